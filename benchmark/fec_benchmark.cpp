@@ -0,0 +1,146 @@
+#include <lnl/net_manager.h>
+#include <lnl/net_event_based_listener.h>
+#include <lnl/net_utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//sends unreliable messages over localhost while the receiver drops a share of the datagrams,
+//then reports how many arrived and how late, with and without forward error correction
+namespace {
+    constexpr uint32_t MESSAGES = 1000;
+    constexpr uint32_t PAYLOAD_SIZE = 64;
+    constexpr auto SEND_INTERVAL = std::chrono::milliseconds(1);
+
+    struct result {
+        uint32_t delivered = 0;
+        double mean_latency = 0.;
+        double p99_latency = 0.;
+    };
+
+    void poll(lnl::net_manager& server, lnl::net_manager& client, std::chrono::milliseconds duration) {
+        auto end = std::chrono::steady_clock::now() + duration;
+
+        while (std::chrono::steady_clock::now() < end) {
+            server.poll_events();
+            client.poll_events();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    result run(int32_t lossChance, uint8_t fecGroupSize) {
+        static thread_local lnl::net_data_writer writer;
+
+        std::vector<bool> received(MESSAGES, false);
+        std::vector<double> latencies;
+        std::shared_ptr<lnl::net_peer> clientPeer;
+
+        lnl::net_event_based_listener serverListener;
+        lnl::net_event_based_listener clientListener;
+
+        serverListener.connection_request().subscribe([](auto& request) {
+            request->accept();
+        });
+
+        serverListener.network_receive().subscribe([&](auto& peer,
+                                                       lnl::net_data_reader& reader,
+                                                       auto channel,
+                                                       auto method) {
+            auto idx = reader.read<uint32_t>();
+            auto sendTime = reader.read<int64_t>();
+
+            if (idx >= MESSAGES || received[idx]) {
+                return;
+            }
+
+            received[idx] = true;
+            latencies.push_back((double) (lnl::get_current_time() - sendTime) / lnl::TICKS_PER_MILLISECOND);
+        });
+
+        clientListener.peer_connected().subscribe([&](auto& peer) {
+            clientPeer = peer;
+        });
+
+        lnl::net_manager server(&serverListener);
+        lnl::net_manager client(&clientListener);
+
+        for (auto manager: {&server, &client}) {
+            manager->fec_group_size = fecGroupSize;
+        }
+
+        server.start();
+        client.start();
+
+        lnl::net_address serverAddress(server.address());
+        serverAddress.set_address("localhost");
+
+        client.connect(serverAddress, writer);
+
+        for (int _ = 0; _ < 100 && !clientPeer; ++_) {
+            poll(server, client, std::chrono::milliseconds(10));
+        }
+
+        if (!clientPeer) {
+            printf("connection failed\n");
+            return {};
+        }
+
+        server.simulation_packet_loss_chance = lossChance;
+        server.simulate_packet_loss = lossChance > 0;
+
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            writer.write(lnl::get_current_time());
+
+            for (uint32_t j = writer.size(); j < PAYLOAD_SIZE; ++j) {
+                writer.write((uint8_t) j);
+            }
+
+            clientPeer->send(writer, lnl::DELIVERY_METHOD::UNRELIABLE);
+            poll(server, client, SEND_INTERVAL);
+        }
+
+        poll(server, client, std::chrono::milliseconds(200));
+
+        result result;
+        result.delivered = (uint32_t) latencies.size();
+
+        if (!latencies.empty()) {
+            std::sort(latencies.begin(), latencies.end());
+
+            for (auto latency: latencies) {
+                result.mean_latency += latency;
+            }
+
+            result.mean_latency /= (double) latencies.size();
+            result.p99_latency = latencies[latencies.size() * 99 / 100];
+        }
+
+        return result;
+    }
+}
+
+int main() {
+    static constexpr int32_t LOSS_CHANCES[] = {0, 5, 10, 20, 30};
+    static constexpr uint8_t FEC_GROUP_SIZES[] = {0, 8, 4};
+
+    printf("%6s %6s %10s %12s %12s\n", "loss%", "fec k", "delivered", "mean ms", "p99 ms");
+
+    for (auto lossChance: LOSS_CHANCES) {
+        for (auto fecGroupSize: FEC_GROUP_SIZES) {
+            auto result = run(lossChance, fecGroupSize);
+
+            printf("%6d %6d %9.1f%% %12.3f %12.3f\n",
+                   lossChance,
+                   fecGroupSize,
+                   100. * result.delivered / MESSAGES,
+                   result.mean_latency,
+                   result.p99_latency);
+        }
+    }
+
+    return 0;
+}
@@ -33,16 +33,40 @@ namespace lnl {
 
         void add_to_queue(net_packet* packet);
 
+        //size of the ack state written by write_ack
+        [[nodiscard]] virtual size_t ack_size() const {
+            return 0;
+        }
+
+        //current ack state without the property byte for queued acks, 0 if the channel has none or it doesn't fit
+        virtual size_t write_ack(uint8_t* dst, size_t capacity) {
+            return 0;
+        }
+
     protected:
         virtual bool send_next_packets() = 0;
 
         void add_to_peer_channel_send_queue();
 
+        //new packets wait while the quantum of this scheduling round or the peer egress credit is used up
+        [[nodiscard]] bool has_send_quota() const;
+
+        //sends the ack packet right away or queues it on the peer to be combined
+        void send_ack(net_packet* ack);
+
         net_peer* m_peer;
         net_queue<net_packet*> m_outgoing_queue;
         std::atomic<bool> m_can_enqueue = true;
 
     private:
         uint32_t m_is_added_to_peer_channel_send_queue = 0;
+        //queued ack not sent yet, guarded by the peer send mutex
+        bool m_ack_queued = false;
+        //deficit round robin state, guarded by the peer send mutex
+        uint8_t m_priority = 0;
+        uint32_t m_weight = 1;
+        int64_t m_deficit = 0;
+
+        friend class net_peer;
     };
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <lnl/channels/net_notified_channel.h>
+#include <lnl/net_delta.h>
+
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace lnl {
+    //snapshots sent per key are encoded against the newest snapshot of the key the receiver acked
+    //[channeled header][key u16][version u16][baseline version u16][snapshot size u16][delta or snapshot]
+    class net_delta_channel final : public net_notified_channel {
+        static constexpr uint16_t NO_BASELINE = UINT16_MAX;
+        //received snapshots kept per key, older baselines are not used and a full snapshot is sent instead
+        static constexpr int32_t HISTORY_SIZE = 32;
+        //received keys, the least recently used ones are forgotten beyond either limit,
+        //their sender falls back to a full snapshot once its deltas stay unacked
+        static constexpr size_t MAX_INCOMING_KEYS = 1024;
+        static constexpr size_t MAX_INCOMING_BYTES = 4 * 1024 * 1024;
+
+        struct snapshot {
+            uint16_t version = 0;
+            std::vector<uint8_t> data;
+        };
+
+        struct sent_snapshot {
+            uint16_t key = 0;
+            snapshot value;
+        };
+
+        struct outgoing_key {
+            uint16_t next_version = 0;
+            std::optional<snapshot> baseline;
+        };
+
+        struct incoming_key {
+            std::deque<snapshot> history;
+            uint64_t last_use = 0;
+        };
+
+    public:
+        net_delta_channel(net_peer* peer, uint8_t id, int32_t windowSize = net_constants::DEFAULT_WINDOW_SIZE)
+                : net_notified_channel(peer, id, windowSize) {}
+
+        ~net_delta_channel() override;
+
+        void send(const uint8_t* data, size_t offset, size_t size, uint16_t key);
+
+    protected:
+        bool deliver(net_packet* packet) override;
+
+        void on_delivered(void* userData) override;
+
+        void on_lost(void* userData) override;
+
+    private:
+        net_mutex m_outgoing_mutex;
+        std::unordered_map<uint16_t, outgoing_key> m_outgoing_keys;
+        net_delta_codec m_codec;
+
+        //only the receive thread touches these
+        std::unordered_map<uint16_t, incoming_key> m_incoming_keys;
+        size_t m_incoming_bytes = 0;
+        uint64_t m_incoming_uses = 0;
+
+        void forget_incoming_keys(uint16_t keep);
+    };
+}
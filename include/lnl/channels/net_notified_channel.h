@@ -0,0 +1,94 @@
+#pragma once
+
+#include <lnl/channels/net_base_channel.h>
+#include <lnl/net_bitmap.h>
+#include <lnl/net_mutex.h>
+
+#include <vector>
+
+namespace lnl {
+    //unreliable and unordered, never resends, but acks every packet with the ack bitmap of the reliable channel
+    //so messages sent with a delivery event are reported as delivered or lost
+    class net_notified_channel : public net_base_channel {
+        static constexpr int32_t BITS_IN_BYTE = 8;
+
+        struct pending_message {
+            int32_t sequence = 0;
+            int64_t deadline = 0;
+            void* user_data = nullptr;
+        };
+
+    public:
+        //window size must be a multiple of 64 and match on both sides
+        net_notified_channel(net_peer* peer, uint8_t id, int32_t windowSize = net_constants::DEFAULT_WINDOW_SIZE)
+                : net_base_channel(peer),
+                  m_id(id),
+                  m_window_size(windowSize),
+                  m_outgoing_acks(PACKET_PROPERTY::ACK, (windowSize - 1) / BITS_IN_BYTE + 2) {
+            m_outgoing_acks.set_channel_id(id);
+            m_pending.resize(m_window_size);
+            m_pending_mask.resize(m_window_size / BITMAP_WORD_BITS, 0);
+        }
+
+        bool process_packet(net_packet* packet) override;
+
+        [[nodiscard]] size_t ack_size() const override;
+
+        size_t write_ack(uint8_t* dst, size_t capacity) override;
+
+    protected:
+        //hands a new packet to the user, it's not acked when this returns false, it's taken when this returns true
+        virtual bool deliver(net_packet* packet);
+
+        virtual void on_delivered(void* userData);
+
+        virtual void on_lost(void* userData);
+
+        //calls handler(userData) for every message still waiting for its ack and forgets them
+        template <typename T>
+        void clear_pending(T&& handler) {
+            net_mutex_guard guard(m_pending_mutex);
+
+            for (size_t idx = 0; idx < m_pending.size(); ++idx) {
+                if ((m_pending_mask[idx / BITMAP_WORD_BITS] & (1ull << (idx % BITMAP_WORD_BITS))) != 0) {
+                    bitmap_reset(m_pending_mask.data(), idx);
+                    handler(m_pending[idx].user_data);
+                }
+            }
+
+            m_pending_count = 0;
+        }
+
+        uint8_t m_id;
+
+    private:
+        bool send_next_packets() override;
+
+        void process_ack(net_packet* packet);
+
+        //starts tracking a sent message, messages a window or more older are lost if still pending
+        void add_pending(uint16_t sequence, void* userData, int64_t currentTime);
+
+        //reports pending messages as lost from the oldest one while they are past their deadline
+        //or older than lostBefore, -1 if there is no such bound
+        void expire_pending(int64_t currentTime, int32_t lostBefore);
+
+        void report_lost(size_t idx);
+
+        int32_t m_window_size;
+
+        int32_t m_local_sequence = 0;
+        int32_t m_remote_window_start = 0;
+
+        bool m_must_send_acks = false;
+
+        net_mutex m_outgoing_acks_mutex;
+        net_packet m_outgoing_acks;
+        net_mutex m_pending_mutex;
+        //only messages with user data are tracked, the oldest one is at or after m_local_window_start
+        int32_t m_local_window_start = 0;
+        int32_t m_pending_count = 0;
+        std::vector<pending_message> m_pending;
+        std::vector<uint64_t> m_pending_mask;
+    };
+}
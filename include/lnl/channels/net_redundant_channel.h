@@ -0,0 +1,53 @@
+#pragma once
+
+#include <lnl/channels/net_base_channel.h>
+#include <lnl/net_mutex.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace lnl {
+    //every packet carries the newest message and the older ones not acknowledged yet, newest first:
+    //[channeled header, sequence of the newest][size u16][message]...
+    //each message is delivered once, late ones within the window included
+    class net_redundant_channel final : public net_base_channel {
+        //delivered sequences tracked behind the newest one
+        static constexpr int32_t WINDOW_SIZE = 64;
+
+    public:
+        net_redundant_channel(net_peer* peer, uint8_t id);
+
+        ~net_redundant_channel() override;
+
+        bool process_packet(net_packet* packet) override;
+
+        [[nodiscard]] size_t ack_size() const override;
+
+        size_t write_ack(uint8_t* dst, size_t capacity) override;
+
+    private:
+        bool send_next_packets() override;
+
+        //sends the newest pending message with as many older ones as fit, the rest are dropped
+        void send_pending();
+
+        void process_ack(uint16_t sequence);
+
+        void deliver(const net_packet* packet, size_t pos, size_t size);
+
+        uint8_t m_id;
+
+        int32_t m_local_sequence = 0;
+        //queued messages are already records after the channeled header, oldest first
+        std::deque<net_packet*> m_pending;
+        net_mutex m_pending_mutex;
+
+        uint16_t m_remote_sequence = 0;
+        uint64_t m_delivered = 1;
+        std::vector<size_t> m_records;
+
+        std::unique_ptr<net_packet> m_ack_packet;
+        bool m_must_send_ack = false;
+    };
+}
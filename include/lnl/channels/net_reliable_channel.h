@@ -1,37 +1,88 @@
 #pragma once
 
 #include <lnl/channels/net_base_channel.h>
+#include <lnl/net_bitmap.h>
 #include <lnl/net_mutex.h>
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+
 namespace lnl {
     class net_reliable_channel final : public net_base_channel {
         static constexpr int32_t BITS_IN_BYTE = 8;
+        //resend delay doubles per attempt, up to 2^MAX_RESEND_BACKOFF times
+        static constexpr int32_t MAX_RESEND_BACKOFF = 3;
+        //a packet is resent without waiting for its timer once this many later sent packets are acked
+        static constexpr int32_t FAST_RETRANSMIT_THRESHOLD = 3;
 
         class pending_packet {
             net_packet* m_packet = nullptr;
             int64_t m_timestamp = 0;
-            bool m_is_sent = false;
+            int64_t m_deadline = 0;
+            int32_t m_resend_count = 0;
+            //counted by the peer congestion controller
+            bool m_in_flight = false;
 
         public:
             void init(net_packet* packet) {
                 m_packet = packet;
-                m_is_sent = false;
+                m_resend_count = 0;
+                m_in_flight = false;
+            }
+
+            [[nodiscard]] bool is_due(int64_t deadline, uint16_t sequence) const {
+                return m_packet != nullptr && m_deadline == deadline && m_packet->sequence() == sequence;
+            }
+
+            [[nodiscard]] size_t size() const {
+                return m_packet->size();
+            }
+
+            [[nodiscard]] int64_t sent_time() const {
+                return m_timestamp;
+            }
+
+            //makes the packet due for resend now, returns false if it already was
+            bool expire(int64_t currentTime) {
+                if (m_deadline <= currentTime) {
+                    return false;
+                }
+
+                m_deadline = currentTime;
+                return true;
             }
 
-            bool try_send(int64_t currentTime, net_peer* peer);
+            //sends the packet and returns the time it should be resent at
+            int64_t send(int64_t currentTime, net_peer* peer);
 
-            bool clear(net_peer* peer);
+            //resend timer expired, the previous copy no longer counts as in flight
+            void mark_lost(int64_t currentTime, net_peer* peer);
+
+            bool clear(int64_t currentTime, net_peer* peer);
+        };
+
+        struct resend_entry {
+            int64_t deadline;
+            uint16_t sequence;
+
+            bool operator>(const resend_entry& other) const {
+                return deadline > other.deadline;
+            }
         };
 
     public:
-        net_reliable_channel(net_peer* peer, bool ordered, uint8_t id)
+        //window size must be a power of two of at least 64 and match on both sides
+        net_reliable_channel(net_peer* peer, bool ordered, uint8_t id,
+                             int32_t windowSize = net_constants::DEFAULT_WINDOW_SIZE)
                 : net_base_channel(peer),
                   m_ordered(ordered),
                   m_id(id),
-                  m_window_size(net_constants::DEFAULT_WINDOW_SIZE),
-                  m_outgoing_acks(PACKET_PROPERTY::ACK, (net_constants::DEFAULT_WINDOW_SIZE - 1) / BITS_IN_BYTE + 2) {
+                  m_window_size(windowSize),
+                  m_outgoing_acks(PACKET_PROPERTY::ACK, (windowSize - 1) / BITS_IN_BYTE + 2) {
             m_outgoing_acks.set_channel_id(id);
             m_pending_packets.resize(m_window_size);
+            m_pending_mask.resize(m_window_size / BITMAP_WORD_BITS, 0);
 
             if (ordered) {
                 m_delivery_method = DELIVERY_METHOD::RELIABLE_ORDERED;
@@ -44,11 +95,21 @@ namespace lnl {
 
         bool process_packet(net_packet* packet) override;
 
+        [[nodiscard]] size_t ack_size() const override;
+
+        size_t write_ack(uint8_t* dst, size_t capacity) override;
+
     private:
         bool send_next_packets() override;
 
         void process_ack(net_packet* packet);
 
+        //appends the records of the following queued messages to packet while they fit into the mtu
+        void bundle(net_packet* packet);
+
+        //expires packets sent before the newest acked one and at least FAST_RETRANSMIT_THRESHOLD sequences behind it
+        bool fast_retransmit(int32_t newestAckedRelate, int64_t newestAckedTime, int64_t currentTime);
+
         int32_t m_local_sequence = 0;
         int32_t m_remote_sequence = 0;
         int32_t m_local_window_start = 0;
@@ -65,6 +126,10 @@ namespace lnl {
         net_packet m_outgoing_acks;
         net_mutex m_pending_packets_mutex;
         std::vector<pending_packet> m_pending_packets;
+        //bit per window slot holding a packet that is not acked yet
+        std::vector<uint64_t> m_pending_mask;
+        //sent packets ordered by resend deadline, acked ones are dropped lazily
+        std::priority_queue<resend_entry, std::vector<resend_entry>, std::greater<>> m_resend_queue;
         std::vector<net_packet*> m_received_packets;
         std::vector<bool> m_early_received;
     };
@@ -14,12 +14,17 @@ namespace lnl {
             }
 
             m_ack_packet = std::make_unique<net_packet>(PACKET_PROPERTY::ACK, 0);
+            m_ack_packet->set_channel_id(id);
         }
 
         ~net_sequenced_channel() override;
 
         bool process_packet(net_packet* packet) override;
 
+        [[nodiscard]] size_t ack_size() const override;
+
+        size_t write_ack(uint8_t* dst, size_t capacity) override;
+
     private:
         bool send_next_packets() override;
 
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <lnl/congestion/net_congestion_controller.h>
+#include <lnl/net_constants.h>
+
+namespace lnl {
+    //reno style: slow start, then one segment per window of acks, halve on loss once per recovery period
+    class net_aimd_congestion_controller final : public net_congestion_controller {
+        static constexpr size_t INITIAL_WINDOW_SEGMENTS = 10;
+        static constexpr size_t MIN_WINDOW_SEGMENTS = 2;
+
+        size_t m_segment_size;
+        size_t m_window;
+        size_t m_slow_start_threshold = SIZE_MAX;
+        //losses of packets sent before this point belong to the last reduction
+        int64_t m_recovery_start = 0;
+
+    public:
+        explicit net_aimd_congestion_controller(size_t segmentSize = net_constants::MAX_PACKET_SIZE)
+                : m_segment_size(segmentSize),
+                  m_window(segmentSize * INITIAL_WINDOW_SEGMENTS) {}
+
+        [[nodiscard]] size_t congestion_window() const override {
+            return m_window;
+        }
+
+    protected:
+        void on_acked(size_t bytes, int64_t rtt, int64_t currentTime) override;
+
+        void on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) override;
+    };
+}
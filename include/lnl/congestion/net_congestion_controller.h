@@ -0,0 +1,85 @@
+#pragma once
+
+#include <lnl/net_utils.h>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lnl {
+    struct net_congestion_state final {
+        size_t congestion_window = 0; //bytes
+        size_t bytes_in_flight = 0;
+        double pacing_rate = 0.; //bytes per second, 0 when not paced
+        int64_t min_rtt = 0; //ticks
+        uint64_t acked_bytes = 0;
+        uint64_t lost_bytes = 0;
+        uint32_t loss_events = 0;
+    };
+
+    //limits the reliable bytes in flight across all channels of a peer
+    //all times are in ticks as returned by get_current_time()
+    class net_congestion_controller {
+        static constexpr double PACING_GAIN = 1.25;
+    public:
+        virtual ~net_congestion_controller() = default;
+
+        //an empty pipe always accepts one packet, so a tiny window can't stall the peer
+        [[nodiscard]] bool can_send(size_t bytes) const {
+            return m_bytes_in_flight == 0 || m_bytes_in_flight + bytes <= congestion_window();
+        }
+
+        void on_packet_sent(size_t bytes, int64_t currentTime) {
+            m_bytes_in_flight += bytes;
+            on_sent(bytes, currentTime);
+        }
+
+        //rtt is 0 when the packet was resent and the sample is ambiguous
+        void on_packet_acked(size_t bytes, int64_t rtt, int64_t currentTime) {
+            m_bytes_in_flight -= bytes < m_bytes_in_flight ? bytes : m_bytes_in_flight;
+            m_acked_bytes += bytes;
+            on_acked(bytes, rtt, currentTime);
+        }
+
+        void on_packet_lost(size_t bytes, int64_t sentTime, int64_t currentTime) {
+            m_bytes_in_flight -= bytes < m_bytes_in_flight ? bytes : m_bytes_in_flight;
+            m_lost_bytes += bytes;
+            on_lost(bytes, sentTime, currentTime);
+        }
+
+        [[nodiscard]] virtual size_t congestion_window() const = 0;
+
+        //by default one window per min rtt with some headroom
+        [[nodiscard]] virtual double pacing_rate() const {
+            if (m_min_rtt <= 0) {
+                return 0.;
+            }
+
+            return PACING_GAIN * (double) congestion_window() * TICKS_PER_SECOND / (double) m_min_rtt;
+        }
+
+        [[nodiscard]] net_congestion_state state() const {
+            net_congestion_state result;
+            result.congestion_window = congestion_window();
+            result.bytes_in_flight = m_bytes_in_flight;
+            result.pacing_rate = pacing_rate();
+            result.min_rtt = m_min_rtt;
+            result.acked_bytes = m_acked_bytes;
+            result.lost_bytes = m_lost_bytes;
+            result.loss_events = m_loss_events;
+            return result;
+        }
+
+    protected:
+        virtual void on_sent(size_t bytes, int64_t currentTime) {}
+
+        virtual void on_acked(size_t bytes, int64_t rtt, int64_t currentTime) = 0;
+
+        virtual void on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) = 0;
+
+        size_t m_bytes_in_flight = 0;
+        int64_t m_min_rtt = 0;
+        uint64_t m_acked_bytes = 0;
+        uint64_t m_lost_bytes = 0;
+        uint32_t m_loss_events = 0;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <lnl/congestion/net_congestion_controller.h>
+#include <lnl/net_constants.h>
+#include <lnl/net_utils.h>
+
+#include <array>
+
+namespace lnl {
+    //bbr-like: models the path as bottleneck bandwidth x min rtt and keeps about that much in flight,
+    //so queueing delay stays low instead of growing until packets drop
+    class net_delay_congestion_controller final : public net_congestion_controller {
+        static constexpr size_t INITIAL_WINDOW_SEGMENTS = 10;
+        static constexpr size_t MIN_WINDOW_SEGMENTS = 4;
+        static constexpr size_t BANDWIDTH_FILTER_LENGTH = 10; //rounds
+        static constexpr int64_t MIN_RTT_EXPIRATION = 10 * TICKS_PER_SECOND;
+        static constexpr int64_t MIN_ROUND_TIME = 5 * TICKS_PER_MILLISECOND;
+        static constexpr double STARTUP_GAIN = 2.89;
+        static constexpr double CWND_GAIN = 2.;
+        static constexpr int32_t STARTUP_FULL_ROUNDS = 3;
+        static constexpr std::array<double, 8> PROBE_GAINS{1.25, 0.75, 1., 1., 1., 1., 1., 1.};
+
+        enum class MODE {
+            STARTUP,
+            DRAIN,
+            PROBE_BANDWIDTH
+        };
+
+        size_t m_segment_size;
+        MODE m_mode = MODE::STARTUP;
+
+        //delivery rate samples, bytes per second
+        std::array<double, BANDWIDTH_FILTER_LENGTH> m_bandwidth_samples{};
+        size_t m_round = 0;
+        int64_t m_round_start = 0;
+        uint64_t m_round_acked = 0;
+        double m_bottleneck_bandwidth = 0.;
+
+        int64_t m_min_rtt_stamp = 0;
+
+        double m_full_bandwidth = 0.;
+        int32_t m_full_bandwidth_rounds = 0;
+        size_t m_probe_phase = 0;
+
+    public:
+        explicit net_delay_congestion_controller(size_t segmentSize = net_constants::MAX_PACKET_SIZE)
+                : m_segment_size(segmentSize) {}
+
+        [[nodiscard]] size_t congestion_window() const override;
+
+        [[nodiscard]] double pacing_rate() const override;
+
+    protected:
+        void on_acked(size_t bytes, int64_t rtt, int64_t currentTime) override;
+
+        void on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) override;
+
+    private:
+        [[nodiscard]] double bandwidth_delay_product() const {
+            return m_bottleneck_bandwidth * (double) m_min_rtt / TICKS_PER_SECOND;
+        }
+
+        void finish_round(int64_t currentTime);
+    };
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//word-at-a-time helpers for the ack bitmaps, bit N of a bitmap is bit (N % 8) of byte (N / 8)
+namespace lnl {
+    static constexpr size_t BITMAP_WORD_BITS = 64;
+
+    inline int32_t count_trailing_zeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return (int32_t) index;
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    inline int32_t pop_count(uint64_t value) {
+#ifdef _MSC_VER
+        return (int32_t) __popcnt64(value);
+#else
+        return __builtin_popcountll(value);
+#endif
+    }
+
+    //bitmaps inside packets are not aligned, so words are always moved with memcpy
+    inline uint64_t bitmap_load_word(const uint8_t* bits, size_t wordIdx) {
+        uint64_t word;
+        memcpy(&word, &bits[wordIdx * sizeof(uint64_t)], sizeof(uint64_t));
+        return word;
+    }
+
+    inline void bitmap_store_word(uint8_t* bits, size_t wordIdx, uint64_t word) {
+        memcpy(&bits[wordIdx * sizeof(uint64_t)], &word, sizeof(uint64_t));
+    }
+
+    inline void bitmap_set(uint64_t* words, size_t idx) {
+        words[idx / BITMAP_WORD_BITS] |= 1ull << (idx % BITMAP_WORD_BITS);
+    }
+
+    inline void bitmap_reset(uint64_t* words, size_t idx) {
+        words[idx / BITMAP_WORD_BITS] &= ~(1ull << (idx % BITMAP_WORD_BITS));
+    }
+
+    //clears [from, to) of a packed bitmap, to <= bitCount
+    inline void bitmap_clear_linear(uint8_t* bits, size_t from, size_t to) {
+        if (from >= to) {
+            return;
+        }
+
+        auto firstWord = from / BITMAP_WORD_BITS;
+        auto lastWord = (to - 1) / BITMAP_WORD_BITS;
+        auto headMask = ~0ull << (from % BITMAP_WORD_BITS);
+        auto tailMask = ~0ull >> (BITMAP_WORD_BITS - 1 - (to - 1) % BITMAP_WORD_BITS);
+
+        if (firstWord == lastWord) {
+            bitmap_store_word(bits, firstWord, bitmap_load_word(bits, firstWord) & ~(headMask & tailMask));
+            return;
+        }
+
+        bitmap_store_word(bits, firstWord, bitmap_load_word(bits, firstWord) & ~headMask);
+        memset(&bits[(firstWord + 1) * sizeof(uint64_t)], 0, (lastWord - firstWord - 1) * sizeof(uint64_t));
+        bitmap_store_word(bits, lastWord, bitmap_load_word(bits, lastWord) & ~tailMask);
+    }
+
+    //clears count bits starting at from, wrapping around a bitmap of bitCount bits (a multiple of 64)
+    inline void bitmap_clear_circular(uint8_t* bits, size_t bitCount, size_t from, size_t count) {
+        if (count >= bitCount) {
+            memset(bits, 0, bitCount / 8);
+            return;
+        }
+
+        if (from + count <= bitCount) {
+            bitmap_clear_linear(bits, from, from + count);
+            return;
+        }
+
+        bitmap_clear_linear(bits, from, bitCount);
+        bitmap_clear_linear(bits, 0, from + count - bitCount);
+    }
+
+    //calls handler(bitIdx) for every bit set in both bitmaps
+    template <typename T>
+    inline void bitmap_for_each_common(const uint8_t* bits, const uint64_t* words, size_t wordCount, T&& handler) {
+        size_t wordIdx = 0;
+
+#if defined(__AVX2__)
+        //skip 256 bit blocks with nothing in common
+        for (; wordIdx + 4 <= wordCount; wordIdx += 4) {
+            auto a = _mm256_loadu_si256((const __m256i*) &bits[wordIdx * sizeof(uint64_t)]);
+            auto b = _mm256_loadu_si256((const __m256i*) &words[wordIdx]);
+
+            if (_mm256_testz_si256(a, b)) {
+                continue;
+            }
+
+            for (size_t i = wordIdx; i < wordIdx + 4; ++i) {
+                for (auto word = bitmap_load_word(bits, i) & words[i]; word != 0; word &= word - 1) {
+                    handler(i * BITMAP_WORD_BITS + count_trailing_zeros(word));
+                }
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        //skip 128 bit blocks with nothing in common
+        auto zero = _mm_setzero_si128();
+
+        for (; wordIdx + 2 <= wordCount; wordIdx += 2) {
+            auto a = _mm_loadu_si128((const __m128i*) &bits[wordIdx * sizeof(uint64_t)]);
+            auto b = _mm_loadu_si128((const __m128i*) &words[wordIdx]);
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(a, b), zero)) == 0xFFFF) {
+                continue;
+            }
+
+            for (size_t i = wordIdx; i < wordIdx + 2; ++i) {
+                for (auto word = bitmap_load_word(bits, i) & words[i]; word != 0; word &= word - 1) {
+                    handler(i * BITMAP_WORD_BITS + count_trailing_zeros(word));
+                }
+            }
+        }
+#endif
+
+        for (; wordIdx < wordCount; ++wordIdx) {
+            for (auto word = bitmap_load_word(bits, wordIdx) & words[wordIdx]; word != 0; word &= word - 1) {
+                handler(wordIdx * BITMAP_WORD_BITS + count_trailing_zeros(word));
+            }
+        }
+    }
+
+    //circular distance from `from` to the next set bit, bitCount if there is none
+    inline size_t bitmap_distance_to_next_set(const uint64_t* words, size_t bitCount, size_t from) {
+        auto wordCount = bitCount / BITMAP_WORD_BITS;
+        auto wordIdx = from / BITMAP_WORD_BITS;
+        auto word = words[wordIdx] & (~0ull << (from % BITMAP_WORD_BITS));
+
+        for (size_t scanned = 0; scanned <= wordCount; ++scanned) {
+            if (word != 0) {
+                auto idx = wordIdx * BITMAP_WORD_BITS + count_trailing_zeros(word);
+                return (idx + bitCount - from) % bitCount;
+            }
+
+            wordIdx = (wordIdx + 1) % wordCount;
+            word = words[wordIdx];
+        }
+
+        return bitCount;
+    }
+}
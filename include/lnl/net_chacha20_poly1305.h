@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    //one datagram of a batch, sealed or opened in place
+    struct net_aead_job final {
+        const class net_chacha20_poly1305* cipher = nullptr;
+        uint64_t nonce = 0;
+        //authenticated but left as it is
+        const uint8_t* ad = nullptr;
+        size_t ad_size = 0;
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        //written by seal, checked by open
+        uint8_t* tag = nullptr;
+        //set by open, the data is only decrypted when the tag matched
+        bool valid = false;
+    };
+
+    //rfc 8439 aead, the 96 bit nonce is the prefix of the cipher followed by the 64 bit nonce of the job
+    class net_chacha20_poly1305 final {
+    public:
+        static constexpr size_t KEY_SIZE = 32;
+        static constexpr size_t TAG_SIZE = 16;
+        //input of derive_key
+        static constexpr size_t SALT_SIZE = 16;
+
+    private:
+        std::array<uint32_t, 8> m_key{};
+        uint32_t m_nonce_prefix;
+
+        static void process_batch(net_aead_job* jobs, size_t count, bool seal);
+
+    public:
+        net_chacha20_poly1305(const uint8_t* key, uint32_t noncePrefix);
+
+        //hchacha20, a key of its own for every salt, reveals nothing about the one it came from
+        static void derive_key(const uint8_t* key, const uint8_t* salt, uint8_t* subkey);
+
+        //keystream blocks of all jobs are generated four at a time
+        static void seal_batch(net_aead_job* jobs, size_t count);
+
+        static void open_batch(net_aead_job* jobs, size_t count);
+    };
+}
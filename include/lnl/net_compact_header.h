@@ -0,0 +1,42 @@
+#pragma once
+
+#include <lnl/net_packet.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    //the records of a MERGED packet with packed headers and varint sizes
+    //COMPACT_MERGED: [property][record size varint][record]...
+    //channeled record: [property with flags][channel id][sequence][fragment id u16][part varint][total varint][data]
+    //the channel id is left out with SAME_CHANNEL and the sequence with NEXT_SEQUENCE, otherwise the first
+    //channeled record carries its sequence as u16 and the following ones as a zigzag varint delta to the previous one,
+    //fragment fields follow only on fragmented records, other records keep their layout
+    //the flags take the connection number bits, every record gets the connection number of the COMPACT_MERGED packet
+    class net_compact_writer final {
+    public:
+        static constexpr uint8_t SAME_CHANNEL = 0x20;
+        static constexpr uint8_t NEXT_SEQUENCE = 0x40;
+
+        //rewrites the records of the first size bytes of merged into dst after its property,
+        //returns the size of the COMPACT_MERGED packet or 0 if it doesn't fit into capacity
+        static size_t write(const net_packet* merged, size_t size, net_packet* dst, size_t capacity);
+    };
+
+    class net_compact_reader final {
+        const net_packet* m_packet;
+        size_t m_pos = net_constants::HEADER_SIZE;
+        int32_t m_channel_id = -1;
+        uint16_t m_sequence = 0;
+
+    public:
+        explicit net_compact_reader(const net_packet* packet) : m_packet(packet) {}
+
+        [[nodiscard]] bool has_next() const {
+            return m_pos < m_packet->size();
+        }
+
+        //expands the next record into dst with its usual header, false if it's malformed
+        bool read_next(net_packet* dst);
+    };
+}
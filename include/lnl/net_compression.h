@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lnl {
+    //data both sides know before the first packet, matches may point into it
+    class net_lz_dictionary final {
+        std::vector<uint8_t> m_data;
+        std::vector<uint32_t> m_table;
+
+        friend class net_lz_codec;
+
+    public:
+        //only the last MAX_OFFSET bytes can be referenced, anything before them is dropped
+        explicit net_lz_dictionary(const uint8_t* data, size_t size);
+
+        [[nodiscard]] size_t size() const {
+            return m_data.size();
+        }
+    };
+
+    //lz77 with an lz4 like block layout:
+    //[token: literal count << 4 | match length - MIN_MATCH][literal count 255s][literals][offset u16][match length 255s]
+    //the last sequence has literals only
+    class net_lz_codec final {
+    public:
+        static constexpr size_t MIN_MATCH = 4;
+        static constexpr size_t MAX_OFFSET = UINT16_MAX;
+        static constexpr size_t HASH_BITS = 12;
+
+    private:
+        std::vector<uint32_t> m_table;
+        std::vector<uint8_t> m_window;
+
+    public:
+        net_lz_codec() : m_table(1u << HASH_BITS) {}
+
+        //returns the compressed size, 0 if it doesn't fit into capacity
+        size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                        const net_lz_dictionary* dictionary = nullptr);
+
+        //writes exactly size bytes into dst, returns false on malformed input
+        static bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size,
+                               const net_lz_dictionary* dictionary = nullptr);
+
+        static uint32_t hash(uint32_t value) {
+            return (value * 2654435761u) >> (32 - HASH_BITS);
+        }
+    };
+
+    struct net_compression_stats final {
+        uint64_t compressed_packets = 0;
+        //below net_manager::compression_min_size, not shrunk enough or skipped while compression didn't pay off
+        uint64_t uncompressed_packets = 0;
+        uint64_t decompressed_packets = 0;
+        //datagram bytes before and after the layer
+        uint64_t input_bytes = 0;
+        uint64_t output_bytes = 0;
+        //nanoseconds spent in the codec
+        int64_t compress_time = 0;
+        int64_t decompress_time = 0;
+
+        [[nodiscard]] double ratio() const {
+            return input_bytes == 0 ? 1. : (double) output_bytes / (double) input_bytes;
+        }
+    };
+}
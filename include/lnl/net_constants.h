@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <array>
 
@@ -9,7 +10,7 @@ namespace lnl {
 
         ~net_constants() = delete;
 
-        static constexpr int32_t DEFAULT_WINDOW_SIZE = 64;
+        static constexpr int32_t DEFAULT_WINDOW_SIZE = 64; //ack bitmaps are processed in 64 bit words
         static constexpr int32_t SOCKET_BUFFER_SIZE = 1024 * 1024; //1mb
         static constexpr int32_t SOCKET_TTL = 255;
 
@@ -19,24 +20,51 @@ namespace lnl {
         static constexpr int32_t CONNECT_ACCEPT_HEADER_SIZE = 15;
         static constexpr int32_t FRAGMENT_HEADER_SIZE = 6;
         static constexpr int32_t FRAGMENTED_HEADER_TOTAL_SIZE = CHANNELED_HEADER_SIZE + FRAGMENT_HEADER_SIZE;
+        static constexpr int32_t FEC_DATA_HEADER_SIZE = 4;
+        static constexpr int32_t FEC_REPAIR_HEADER_SIZE = 6;
+        static constexpr int32_t MAX_FEC_GROUP_SIZE = 32; //received packets are tracked in a 32 bit mask
         static constexpr uint16_t MAX_SEQUENCE = 32768;
         static constexpr uint16_t HALF_MAX_SEQUENCE = MAX_SEQUENCE / 2;
 
         static constexpr int32_t PROTOCOL_ID = 13;
         static constexpr int32_t MAX_UDP_HEADER_SIZE = 68;
         static constexpr int32_t CHANNEL_TYPE_COUNT = 4;
+        //delivery methods after UNRELIABLE, their channel ids count down from 255 so they don't depend on
+        //channels_count, with more than 36 channels the higher ones collide with basic ids and can't be used
+        static constexpr int32_t EXTENDED_CHANNEL_TYPE_COUNT = 3;
+        //size in front of each message of REDUNDANT and bundled reliable packets
+        static constexpr int32_t RECORD_HEADER_SIZE = 2;
+        static constexpr int32_t DELTA_HEADER_SIZE = 8;
+        static constexpr size_t CRC32C_SIZE = 4;
+        //poly1305 tag and the low half of the nonce after every encrypted datagram
+        static constexpr size_t ENCRYPTION_TRAILER_SIZE = 20;
+        //issue time u32 and a truncated hmac
+        static constexpr size_t CONNECT_COOKIE_SIZE = 20;
+        static constexpr size_t CONNECT_CHALLENGE_SIZE = HEADER_SIZE + sizeof(int64_t) + CONNECT_COOKIE_SIZE;
+        static constexpr int32_t CHANNEL_PRIORITY_LEVELS = 4;
 
-        static constexpr std::array<int32_t, 7> POSSIBLE_MTU{
+        static constexpr std::array<int32_t, 10> POSSIBLE_MTU{
                 576 - MAX_UDP_HEADER_SIZE,  //minimal (RFC 1191)
                 1024,                       //most games standard
                 1232 - MAX_UDP_HEADER_SIZE,
                 1460 - MAX_UDP_HEADER_SIZE, //google cloud
                 1472 - MAX_UDP_HEADER_SIZE, //VPN
                 1492 - MAX_UDP_HEADER_SIZE, //Ethernet with LLC and SNAP, PPPoE (RFC 1042)
-                1500 - MAX_UDP_HEADER_SIZE  //Ethernet II (RFC 1191)
+                1500 - MAX_UDP_HEADER_SIZE, //Ethernet II (RFC 1191)
+                4352 - MAX_UDP_HEADER_SIZE, //FDDI (RFC 1390)
+                9000 - MAX_UDP_HEADER_SIZE, //Ethernet jumbo frames
+                65535 - MAX_UDP_HEADER_SIZE //largest IPv4 datagram, loopback
         };
+        //candidates probed with the INTERNET and JUMBO mtu profiles, LOOPBACK probes all of them
+        static constexpr size_t INTERNET_MTU_COUNT = 7;
+        static constexpr size_t JUMBO_MTU_COUNT = 9;
 
-        static constexpr int32_t MAX_PACKET_SIZE = POSSIBLE_MTU.back();
+        //largest window whose ack bitmap still fits into the minimal mtu
+        static constexpr int32_t MAX_WINDOW_SIZE = 2048;
+        static_assert(CHANNELED_HEADER_SIZE + (MAX_WINDOW_SIZE - 1) / 8 + 2 <= POSSIBLE_MTU[0]);
+
+        //largest packet of the default INTERNET profile, net_manager::max_packet_size() is the one in use
+        static constexpr int32_t MAX_PACKET_SIZE = POSSIBLE_MTU[INTERNET_MTU_COUNT - 1];
         static constexpr int32_t MAX_UNRELIABLE_DATA_SIZE = MAX_PACKET_SIZE - HEADER_SIZE;
 
         static constexpr uint8_t MAX_CONNECTION_NUMBER = 4;
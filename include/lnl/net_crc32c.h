@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    //crc32c (castagnoli) of size bytes, with the SSE4.2 crc32 instruction when the cpu has it, slicing-by-8 otherwise
+    uint32_t crc32c(const uint8_t* data, size_t size);
+
+    //results[i] = crc32c(data[i], sizes[i]), the instruction has a latency of three, so three datagrams are
+    //interleaved to keep it busy
+    void crc32c_batch(const uint8_t* const* data, const size_t* sizes, uint32_t* results, size_t count);
+}
@@ -62,7 +62,7 @@ namespace lnl {
                 return;
             }
 
-            ensure(size);
+            ensure(m_position + size);
 
             memcpy(&m_data[m_position], &src[srcOffset], size);
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lnl {
+    //xor against a baseline followed by zero run length encoding, unchanged bytes cost nothing:
+    //[zero run varint][literal count varint][literal xor bytes]... trailing zeros are implied
+    //a baseline shorter than the payload is padded with zeros
+    class net_delta_codec final {
+        //shorter zero runs stay inside a literal, their two varints would cost more
+        static constexpr size_t MIN_ZERO_RUN = 3;
+
+        std::vector<uint8_t> m_xor;
+
+    public:
+        //returns false if the encoded data doesn't fit into capacity, it's empty when nothing changed
+        bool encode(const uint8_t* baseline, size_t baselineSize,
+                    const uint8_t* data, size_t size,
+                    uint8_t* dst, size_t capacity, size_t& encodedSize);
+
+        //writes size bytes into dst, returns false on malformed input
+        static bool decode(const uint8_t* baseline, size_t baselineSize,
+                           const uint8_t* src, size_t srcSize,
+                           uint8_t* dst, size_t size);
+    };
+}
@@ -13,7 +13,8 @@ namespace lnl {
         BROADCAST,
         CONNECTION_REQUEST,
         MESSAGE_DELIVERED,
-        PEER_ADDRESS_CHANGED
+        PEER_ADDRESS_CHANGED,
+        MESSAGE_LOST
     };
 
     enum class DISCONNECT_REASON {
@@ -36,7 +37,10 @@ namespace lnl {
         RELIABLE_UNORDERED = 0,
         SEQUENCED = 1,
         RELIABLE_ORDERED = 2,
-        RELIABLE_SEQUENCED = 3
+        RELIABLE_SEQUENCED = 3,
+        REDUNDANT = 5,
+        UNRELIABLE_NOTIFIED = 6,
+        DELTA = 7
     };
 
     enum class UNCONNECTED_MESSAGE_TYPE {
@@ -63,6 +67,18 @@ namespace lnl {
         INVALID_PROTOCOL,
         NAT_MESSAGE,
         EMPTY,
+        //only sent to peers that negotiated the matching PROTOCOL_FEATURE
+        COMPOUND_ACK,
+        //CHANNELED with the ack state of its channel appended
+        CHANNELED_ACK,
+        FEC_DATA,
+        FEC_REPAIR,
+        //MERGED with packed record headers, see net_compact_header.h
+        COMPACT_MERGED,
+        //[property][dictionary channel number + 1 or 0][size varint][lz block of the whole datagram]
+        COMPRESSED,
+        //[property][connection time i64][cookie], the request is sent again with the cookie
+        CONNECT_CHALLENGE,
 
         COUNT
     };
@@ -101,4 +117,35 @@ namespace lnl {
         RECONNECTION,
         NEW_CONNECTION
     };
+
+    //optional protocol features agreed on during connect, values are bit positions
+    enum class PROTOCOL_FEATURE : uint8_t {
+        COMPOUND_ACK,
+        PIGGYBACK_ACK,
+        FEC,
+        //reliable packets are lists of size prefixed messages, several small ones share a sequence
+        RELIABLE_BUNDLE,
+        //merged packets are sent as COMPACT_MERGED
+        COMPACT_HEADER,
+        //datagrams may be sent as COMPRESSED
+        COMPRESSION,
+        //datagrams past the handshake are sealed with keys derived from both KEY_SALT records
+        ENCRYPTION
+    };
+
+    //mtu candidates a peer probes for, a larger one is used only when both sides allow it
+    enum class MTU_PROFILE {
+        //up to Ethernet II, fits internet paths
+        INTERNET,
+        //up to 9000 byte jumbo frames of datacenter links
+        JUMBO,
+        //up to the largest UDP datagram, for loopback
+        LOOPBACK
+    };
+
+    enum class CONGESTION_CONTROL {
+        NONE,
+        AIMD,
+        DELAY_BASED
+    };
 }
@@ -22,6 +22,7 @@ namespace lnl {
     DECLARE_EVENT(network_latency_update, std::shared_ptr<net_peer> &, int);
     DECLARE_EVENT(connection_request, std::shared_ptr<net_connection_request> &);
     DECLARE_EVENT(message_delivered, std::shared_ptr<net_peer> &, void*);
+    DECLARE_EVENT(message_lost, std::shared_ptr<net_peer> &, void*);
 
 #undef DECLARE_EVENT
     protected:
@@ -59,5 +60,9 @@ namespace lnl {
         void on_message_delivered(std::shared_ptr<net_peer>& peer, void* userData) override {
             m_message_delivered(peer, userData);
         }
+
+        void on_message_lost(std::shared_ptr<net_peer>& peer, void* userData) override {
+            m_message_lost(peer, userData);
+        }
     };
 }
\ No newline at end of file
@@ -28,6 +28,8 @@ namespace lnl {
 
         virtual void on_message_delivered(std::shared_ptr<net_peer>& peer, void* userData) {};
 
+        virtual void on_message_lost(std::shared_ptr<net_peer>& peer, void* userData) {};
+
         friend class net_manager;
     };
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <lnl/net_packet.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lnl {
+    //xor parity over groups of packets, one repair packet recovers one lost packet of its group
+    //FEC_DATA:   [property][group u16][index u8][protected packet]
+    //FEC_REPAIR: [property][group u16][group size u8][xor of packet sizes u16][xor of packets]
+    class net_fec_encoder final {
+        uint16_t m_group = 0;
+        uint8_t m_count = 0;
+        uint16_t m_size_xor = 0;
+        size_t m_max_size = 0;
+        std::vector<uint8_t> m_parity;
+
+    public:
+        explicit net_fec_encoder(size_t maxPacketSize = net_constants::MAX_PACKET_SIZE) : m_parity(maxPacketSize, 0) {}
+
+        [[nodiscard]] uint8_t count() const {
+            return m_count;
+        }
+
+        //writes packet wrapped as FEC_DATA into dst and adds it to the group parity
+        void wrap(const net_packet* packet, net_packet* dst);
+
+        //writes the FEC_REPAIR of the current group into dst and starts the next group
+        void write_repair(net_packet* dst);
+    };
+
+    class net_fec_decoder final {
+        //groups that can still be completed, older ones are dropped
+        static constexpr size_t GROUP_SLOTS = 8;
+
+        struct group {
+            int32_t id = -1;
+            uint32_t received = 0;
+            uint8_t size = 0;
+            bool done = false;
+            uint16_t size_xor = 0;
+            size_t max_size = 0;
+            std::vector<uint8_t> parity;
+        };
+
+        std::array<group, GROUP_SLOTS> m_groups;
+        group* m_recovered = nullptr;
+        size_t m_max_packet_size;
+
+    public:
+        explicit net_fec_decoder(size_t maxPacketSize = net_constants::MAX_PACKET_SIZE)
+                : m_max_packet_size(maxPacketSize) {}
+
+        //takes FEC_DATA or FEC_REPAIR, returns the size of a packet it could recover or 0
+        size_t add(const net_packet* packet);
+
+        //copies the packet recovered by the last add
+        void copy_recovered(uint8_t* dst) const;
+
+    private:
+        group* get_group(uint16_t id);
+
+        size_t try_recover(group& group);
+    };
+}
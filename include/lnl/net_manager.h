@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <optional>
+#include <random>
 #include <thread>
 #include <unordered_map>
 
@@ -22,17 +24,21 @@
 #include <lnl/net_logger.h>
 #include <lnl/net_packet.h>
 #include <lnl/net_mutex.h>
+#include <lnl/net_signal.h>
 #include <lnl/net_peer.h>
 #include <lnl/net_event_listener.h>
 #include <lnl/net_connection_request.h>
 #include <lnl/net_address.h>
+#include <lnl/net_sha256.h>
+#include <lnl/net_rate_limiter.h>
 
 namespace lnl {
     class net_manager final {
         //constants
         static constexpr uint32_t RECEIVE_POLLING_TIME = 500000; //0.5 second
+        static constexpr double MAX_EGRESS_CREDIT_TICKS = 2.;
 
-        bool m_running = false;
+        std::atomic<bool> m_running = false;
         SOCKET m_socket = INVALID_SOCKET;
 
         net_logger m_logger;
@@ -40,6 +46,17 @@ namespace lnl {
         std::thread m_receive_thread;
         std::thread m_logic_thread;
 
+        //wakes the logic thread when something is queued for sending
+        net_signal m_logic_signal;
+        //earliest extra wakeup requested by peers, in net_signal::clock duration units
+        std::atomic<int64_t> m_scheduled_wakeup = INT64_MAX;
+        //interrupts the receive thread poll on shutdown
+        net_signal m_receive_signal;
+#ifdef WIN32
+        //select can't wait on m_receive_signal, so shutdown sends a datagram to this loopback socket instead
+        SOCKET m_wakeup_socket = INVALID_SOCKET;
+#endif
+
         net_mutex m_packet_pool_mutex;
         net_packet* m_packet_pool_head = nullptr;
         size_t m_packet_pool_size = 0;
@@ -61,6 +78,41 @@ namespace lnl {
         net_event_listener* m_listener;
 
         net_address m_bind_address;
+
+        std::vector<int32_t> m_channel_window_sizes;
+
+        struct channel_schedule {
+            uint8_t priority = 0;
+            uint32_t weight = 1;
+        };
+
+        std::vector<channel_schedule> m_channel_schedules;
+
+        std::vector<std::unique_ptr<net_lz_dictionary>> m_channel_dictionaries;
+
+        //POSSIBLE_MTU candidates of mtu_profile, taken at start
+        size_t m_mtu_count = net_constants::INTERNET_MTU_COUNT;
+
+        //datagrams taken from the socket per call where the platform allows it
+        static constexpr size_t RECEIVE_BATCH_SIZE = 16;
+
+        std::atomic<uint64_t> m_corrupted_packets = 0;
+        std::atomic<uint64_t> m_unauthenticated_packets = 0;
+
+        //seconds a CONNECT_CHALLENGE cookie is accepted for
+        static constexpr uint32_t CONNECT_COOKIE_LIFETIME = 10;
+
+        //keys the connect cookies, random per manager
+        std::array<uint8_t, net_sha256::DIGEST_SIZE> m_cookie_secret{};
+        std::atomic<uint64_t> m_connect_challenges = 0;
+
+        //per source prefix, used by the receive thread only
+        net_rate_limiter m_reply_limiter;
+        net_rate_limiter m_connect_request_limiter;
+        std::atomic<uint64_t> m_limited_replies = 0;
+        std::atomic<uint64_t> m_limited_connect_requests = 0;
+
+        std::minstd_rand m_simulation_random{std::random_device{}()};
     public:
 #ifdef WIN32
         bool reuse_address = false;
@@ -76,8 +128,61 @@ namespace lnl {
         int32_t reconnect_delay = 500;
         int32_t max_connect_attempts = 10;
         int32_t ping_interval = 1000;
+        //reliable window used by channels without their own size, peers agree on the smaller one of both sides,
+        //a peer without connect extensions uses DEFAULT_WINDOW_SIZE
+        int32_t reliable_window_size = net_constants::DEFAULT_WINDOW_SIZE;
+        //limits reliable bytes in flight per peer, congestion_controller_factory takes precedence when set
+        CONGESTION_CONTROL congestion_control = CONGESTION_CONTROL::NONE;
+        std::function<std::unique_ptr<net_congestion_controller>()> congestion_controller_factory;
+        //spreads each peer's datagrams with a token bucket
+        bool pacing_enabled = false;
+        //bytes per second, 0 takes the rate from the peer congestion controller
+        double pacing_rate = 0.;
+        size_t pacing_burst = 4 * net_constants::MAX_PACKET_SIZE;
+        //sends the acks of all channels of a peer in one packet, used only when both sides enable it
+        bool compound_acks_enabled = false;
+        //appends pending acks to outgoing data of the same channel, used only when both sides enable it
+        bool piggyback_acks_enabled = false;
+        //milliseconds a queued ack may wait for other acks or outgoing data to carry it
+        int32_t ack_delay = 0;
+        //unreliable and sequenced packets per xor repair packet, 0 disables, used only when both sides enable it
+        uint8_t fec_group_size = 0;
+        //packs small reliable messages queued together under one sequence, used only when both sides enable it
+        bool reliable_bundling_enabled = false;
+        //sends merged packets with packed headers and varint sizes, used only when both sides enable it
+        bool compact_headers_enabled = false;
+        //lz compresses datagrams of at least compression_min_size bytes, used only when both sides enable it
+        bool compression_enabled = false;
+        size_t compression_min_size = 64;
+        //unacknowledged older messages repeated in every REDUNDANT packet
+        uint8_t redundant_message_count = 3;
+        //bytes per second for all peers together, shared by net_peer::weight(), 0 is unlimited
+        double max_egress_rate = 0.;
+        //appends a crc32c to every datagram and drops received ones that don't match, must match on both sides
+        bool crc32c_enabled = false;
+        //seals every datagram of a connection with chacha20-poly1305 under a key derived from encryption_key and
+        //salts exchanged on connect, connect data stays readable, must match on both sides
+        bool encryption_enabled = false;
+        std::array<uint8_t, net_chacha20_poly1305::KEY_SIZE> encryption_key{};
+        //unknown addresses have to echo a CONNECT_CHALLENGE cookie before their request allocates anything,
+        //so spoofed ones cost one hmac, peers without cookie support can't connect
+        bool connect_cookies_enabled = false;
+        //PEER_NOT_FOUND, INVALID_PROTOCOL, SHUTDOWN_OK and CONNECT_CHALLENGE replies to addresses without a peer,
+        //per second and at once for every source prefix, 0 is unlimited, read by start
+        double unconnected_reply_rate = 0.;
+        double unconnected_reply_burst = 20.;
+        //connect requests of addresses without a peer, per second and at once for every source prefix
+        double connect_request_rate = 0.;
+        double connect_request_burst = 10.;
+        //leading address bits that make a source prefix, its addresses share the limits above
+        uint8_t rate_limit_prefix_length = 24;
+        //widens the mtu candidates and the receive buffers, read by start
+        MTU_PROFILE mtu_profile = MTU_PROFILE::INTERNET;
         bool auto_recycle = true;
         bool disconnect_on_unreachable = false;
+        //drops received packets at random, for testing
+        bool simulate_packet_loss = false;
+        int32_t simulation_packet_loss_chance = 10; //percent
         std::string name;
 
         explicit net_manager(net_event_listener* listener);
@@ -88,6 +193,46 @@ namespace lnl {
             return m_bind_address;
         }
 
+        [[nodiscard]] size_t mtu_count() const {
+            return m_mtu_count;
+        }
+
+        //largest datagram sent or received with the mtu profile in use
+        [[nodiscard]] int32_t max_packet_size() const {
+            return net_constants::POSSIBLE_MTU[m_mtu_count - 1];
+        }
+
+        //bytes the packet layers add to every datagram, peers leave them out of their mtu
+        [[nodiscard]] size_t packet_layer_size() const {
+            return (crc32c_enabled ? net_constants::CRC32C_SIZE : 0) +
+                   (encryption_enabled ? net_constants::ENCRYPTION_TRAILER_SIZE : 0);
+        }
+
+        //datagrams dropped because of a checksum mismatch
+        [[nodiscard]] uint64_t corrupted_packets() const {
+            return m_corrupted_packets;
+        }
+
+        //datagrams of encrypting peers dropped because they were forged, replayed or sent in the clear
+        [[nodiscard]] uint64_t unauthenticated_packets() const {
+            return m_unauthenticated_packets;
+        }
+
+        //requests answered with a CONNECT_CHALLENGE instead of being processed
+        [[nodiscard]] uint64_t connect_challenges() const {
+            return m_connect_challenges;
+        }
+
+        //replies to addresses without a peer left out by unconnected_reply_rate
+        [[nodiscard]] uint64_t rate_limited_replies() const {
+            return m_limited_replies;
+        }
+
+        //connect requests dropped by connect_request_rate
+        [[nodiscard]] uint64_t rate_limited_connect_requests() const {
+            return m_limited_connect_requests;
+        }
+
         [[nodiscard]] bool is_running() const {
             return m_running;
         }
@@ -106,6 +251,26 @@ namespace lnl {
 
         void pool_recycle(net_packet* packet);
 
+        //overrides reliable_window_size for one channel number, 0 resets to the default
+        void set_channel_window_size(uint8_t channelNumber, int32_t windowSize);
+
+        //effective window size rounded up to a power of two between DEFAULT_WINDOW_SIZE and MAX_WINDOW_SIZE
+        [[nodiscard]] int32_t get_channel_window_size(uint8_t channelNumber) const;
+
+        //channels of a higher priority send first in every pass, channels of the same priority get
+        //weight mtu sized quanta per round, priority is clamped below CHANNEL_PRIORITY_LEVELS
+        void set_channel_priority(uint8_t channelNumber, uint8_t priority, uint32_t weight = 1);
+
+        [[nodiscard]] uint8_t get_channel_priority(uint8_t channelNumber) const;
+
+        [[nodiscard]] uint32_t get_channel_weight(uint8_t channelNumber) const;
+
+        //datagrams led by a packet of the channel are compressed against the dictionary,
+        //it must be set before start and match on both sides, an empty one removes it
+        void set_channel_dictionary(uint8_t channelNumber, const std::vector<uint8_t>& dictionary);
+
+        [[nodiscard]] const net_lz_dictionary* get_channel_dictionary(uint8_t channelNumber) const;
+
         std::shared_ptr<net_peer> first_peer() const {
             return m_head_peer;
         }
@@ -150,10 +315,57 @@ namespace lnl {
 
         bool socket_poll();
 
+        void wake_receive_thread();
+
         void receive_logic();
 
+        //receives into the first slots, taking pool packets for the empty ones, returns how many datagrams arrived
+        size_t receive_batch(net_packet** packets, net_address* addresses);
+
+        //strips the checksum of each packet, recycles and clears the slots that don't match
+        void verify_checksums(net_packet** packets, size_t count);
+
+        //decrypts what peers with keys sealed, all in one batch, recycles and clears the slots that fail
+        //with waitingForKeys, datagrams of peers whose keys may come with a handshake earlier in the batch are
+        //left sealed and flagged there, to be opened once that handshake is processed
+        void open_datagrams(net_packet** packets, const net_address* addresses, size_t count,
+                            bool* waitingForKeys = nullptr);
+
+        //hmac of the address, the connection time and the issue time, writes CONNECT_COOKIE_SIZE bytes
+        void make_connect_cookie(const net_address& address, int64_t connectTime, uint32_t issueTime,
+                                 uint8_t* cookie) const;
+
+        //whether the request carries a cookie issued to its address within CONNECT_COOKIE_LIFETIME
+        [[nodiscard]] bool has_connect_cookie(const net_packet* request, const net_address& address) const;
+
+        void send_connect_challenge(const net_packet* request, net_address& address);
+
+        //rate_limit_prefix_length leading bits of the address
+        [[nodiscard]] uint64_t get_source_prefix(const net_address& address) const;
+
+        //counts what the limits drop
+        bool allow_unconnected_reply(const net_address& address);
+
+        bool allow_connect_request(const net_address& address);
+
         void update_logic();
 
+        void wait_logic(net_signal::clock::time_point nextUpdate);
+
+        void distribute_egress_budget(int32_t elapsed);
+
+        void redistribute_unused_egress(int32_t elapsed);
+
+        //optional features offered to remote peers
+        [[nodiscard]] net_connect_extensions local_extensions() const;
+
+        void wake_logic_thread() {
+            m_logic_signal.notify();
+        }
+
+        //makes the logic thread run a send pass at the given time even if it is before the next tick
+        void schedule_logic_wakeup(net_signal::clock::time_point time);
+
         void on_message_received(net_packet* packet, net_address& addr);
 
         void create_event(net_event_create_args& args);
@@ -201,7 +413,12 @@ namespace lnl {
 
         void message_delivered(const net_address& address, void* userData);
 
+        void message_lost(const net_address& address, void* userData);
+
         //send methods
+        //send_raw result for a datagram larger than the interface mtu, other errors return -1
+        static constexpr int32_t SEND_RESULT_TOO_LARGE = -2;
+
         int32_t send_raw_and_recycle(net_packet* packet, net_address& endpoint);
 
         inline int32_t send_raw(const net_packet* packet, net_address& address) {
@@ -210,10 +427,18 @@ namespace lnl {
 
         int32_t send_raw(const uint8_t* data, size_t offset, size_t length, net_address& endpoint);
 
+        friend class net_base_channel;
+
         friend class net_connection_request;
 
         friend class net_peer;
 
         friend class net_sequenced_channel;
+
+        friend class net_redundant_channel;
+
+        friend class net_notified_channel;
+
+        friend class net_delta_channel;
     };
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <lnl/net_utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    //token bucket spreading a peer's datagrams over time, rate in bytes per second, times in ticks
+    class net_pacer final {
+        double m_rate = 0.;
+        double m_burst = 0.;
+        double m_tokens = 0.;
+        int64_t m_last_refill = 0;
+
+    public:
+        [[nodiscard]] bool enabled() const {
+            return m_rate > 0.;
+        }
+
+        [[nodiscard]] double rate() const {
+            return m_rate;
+        }
+
+        void set_rate(double rate, size_t burst) {
+            if (m_rate <= 0.) {
+                //start with a full bucket
+                m_tokens = (double) burst;
+            }
+
+            m_rate = rate;
+            m_burst = (double) burst;
+            m_tokens = std::min(m_tokens, m_burst);
+        }
+
+        bool try_consume(size_t bytes, int64_t currentTime) {
+            refill(currentTime);
+
+            //a datagram larger than the burst goes out once the bucket is full
+            if (m_tokens < std::min((double) bytes, m_burst)) {
+                return false;
+            }
+
+            m_tokens -= (double) bytes;
+            return true;
+        }
+
+        //ticks until try_consume(bytes) can succeed
+        [[nodiscard]] int64_t delay_for(size_t bytes) const {
+            auto missing = std::min((double) bytes, m_burst) - m_tokens;
+
+            if (missing <= 0. || m_rate <= 0.) {
+                return 0;
+            }
+
+            return (int64_t) (missing / m_rate * TICKS_PER_SECOND) + 1;
+        }
+
+    private:
+        void refill(int64_t currentTime) {
+            if (m_last_refill != 0 && currentTime > m_last_refill) {
+                m_tokens = std::min(m_burst, m_tokens + m_rate * (double) (currentTime - m_last_refill) / TICKS_PER_SECOND);
+            }
+
+            m_last_refill = currentTime;
+        }
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <vector>
@@ -26,6 +27,7 @@ namespace lnl {
                 net_constants::CONNECT_REQUEST_HEADER_SIZE, //CONNECT_REQUEST
                 net_constants::CONNECT_ACCEPT_HEADER_SIZE, //CONNECT_ACCEPT
                 net_constants::HEADER_SIZE + 8, //DISCONNECT
+                net_constants::HEADER_SIZE, //UNCONNECTED_MESSAGE
                 net_constants::HEADER_SIZE, //MTU_CHECK
                 net_constants::HEADER_SIZE, //MTU_OK
                 net_constants::HEADER_SIZE, //BROADCAST
@@ -35,24 +37,31 @@ namespace lnl {
                 net_constants::HEADER_SIZE, //INVALID_PROTOCOL
                 net_constants::HEADER_SIZE, //NAT_MESSAGE
                 net_constants::HEADER_SIZE, //EMPTY
+                net_constants::HEADER_SIZE, //COMPOUND_ACK
+                net_constants::CHANNELED_HEADER_SIZE, //CHANNELED_ACK
+                net_constants::FEC_DATA_HEADER_SIZE, //FEC_DATA
+                net_constants::FEC_REPAIR_HEADER_SIZE, //FEC_REPAIR
+                net_constants::HEADER_SIZE, //COMPACT_MERGED
+                net_constants::HEADER_SIZE, //COMPRESSED
+                net_constants::HEADER_SIZE, //CONNECT_CHALLENGE
         };
+        //property shares the first byte with the connection number and fragmented bit
+        static_assert((uint32_t) PACKET_PROPERTY::COUNT <= 0x1F);
 
         std::vector<uint8_t> m_data;
         size_t m_size = 0;
+        //bytes that may have been written since the last clear, the rest of the buffer is still zero
+        size_t m_dirty_size = 0;
         net_packet* m_next = nullptr;
     public:
         void* user_data = nullptr;
 
         net_packet() {
-            ensure(net_constants::MAX_PACKET_SIZE);
-            m_size = net_constants::MAX_PACKET_SIZE;
+            resize(net_constants::MAX_PACKET_SIZE);
         }
 
         net_packet(PACKET_PROPERTY property, size_t size) {
-            size += net_packet::get_header_size(property);
-            ensure(size);
-            m_size = size;
-            set_property(property);
+            resize(property, size);
         }
 
         [[nodiscard]] size_t get_header_size() const {
@@ -60,7 +69,8 @@ namespace lnl {
         }
 
         void clear() {
-            memset(m_data.data(), 0, m_data.size());
+            memset(m_data.data(), 0, m_dirty_size);
+            m_dirty_size = 0;
         }
 
         [[nodiscard]] const uint8_t* data() const {
@@ -83,6 +93,12 @@ namespace lnl {
         void resize(size_t size) {
             ensure(size);
             m_size = size;
+            m_dirty_size = std::max(m_dirty_size, size);
+        }
+
+        //grows the buffer without touching size, for writers that resize to what they actually wrote
+        void reserve(size_t capacity) {
+            ensure(capacity);
         }
 
         void resize(PACKET_PROPERTY property, size_t size) {
@@ -5,19 +5,37 @@
 #include <lnl/net_queue.h>
 #include <lnl/net_constants.h>
 #include <lnl/net_stopwatch.h>
+#include <lnl/net_pacer.h>
+#include <lnl/net_fec.h>
+#include <lnl/net_compact_header.h>
+#include <lnl/net_compression.h>
+#include <lnl/net_chacha20_poly1305.h>
+#include <lnl/net_rtt_estimator.h>
 #include <lnl/net_data_writer.h>
 #include <lnl/channels/net_base_channel.h>
+#include <lnl/congestion/net_congestion_controller.h>
 #include <lnl/packets/net_connect_request_packet.h>
+#include <array>
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <cmath>
 
 namespace lnl {
     class net_peer {
         static constexpr int32_t SHUTDOWN_DELAY = 300;
+        //bounds of the interval between rounds of mtu probes, which follows the resend delay in between
+        static constexpr int32_t MIN_MTU_CHECK_DELAY = 100;
         static constexpr int32_t MTU_CHECK_DELAY = 1000;
-        static constexpr int32_t MAX_MTU_CHECK_ATTEMPTS = 4;
+        static constexpr int32_t MAX_MTU_CHECK_ATTEMPTS = 5;
+        //datagrams skipped at most after compression didn't pay off, doubled on every miss
+        static constexpr uint32_t MAX_COMPRESSION_BACKOFF = 64;
+        //datagrams waiting for the pacer
+        static constexpr size_t MAX_PACED_QUEUE_SIZE = 64;
+        static constexpr double MIN_RESEND_DELAY = 25.;
+        static constexpr double MAX_RESEND_DELAY = 2000.;
 
         std::shared_ptr<net_peer> m_next_peer;
         std::shared_ptr<net_peer> m_prev_peer;
@@ -27,8 +45,10 @@ namespace lnl {
         int32_t m_remote_id = 0;
         std::atomic<int32_t> m_time_since_last_packet = 0;
 
-        //mtu
+        //mtu, all candidates above the current one up to the limit are probed at once,
+        //the limit drops below candidates the socket refused to send
         size_t m_mtu_idx = 0;
+        size_t m_mtu_limit_idx = 0;
         int32_t m_mtu = 0;
         int32_t m_mtu_check_attempts = 0;
         int32_t m_mtu_check_timer = 0;
@@ -39,11 +59,10 @@ namespace lnl {
         net_stopwatch m_ping_timer;
         int32_t m_ping_send_timer = 0;
         int64_t m_remote_delta = 0;
-        int32_t m_rtt = 0;
-        int32_t m_avg_rtt = 0;
-        int32_t m_rtt_count = 0;
-        int32_t m_rtt_reset_timer = 0;
-        double_t m_resend_delay = 27.;
+        //fed by ping/pong and by acks of reliable packets sent once
+        net_mutex m_rtt_mutex;
+        net_rtt_estimator m_rtt_estimator;
+        std::atomic<double_t> m_resend_delay = 27.;
 
         CONNECTION_STATE m_connection_state = CONNECTION_STATE::DISCONNECTED;
 
@@ -60,12 +79,22 @@ namespace lnl {
         net_packet m_ping_packet;
         std::unique_ptr<net_packet> m_connect_request_packet;
         std::unique_ptr<net_packet> m_connect_accept_packet;
+        //features both sides agreed on
+        net_connect_extensions m_extensions;
 
         //channels
         std::queue<net_packet*> m_unreliable_channel;
         net_mutex m_unreliable_channel_mutex;
         net_queue<net_base_channel*> m_channel_send_queue;
         std::vector<class net_base_channel*> m_channels;
+        //channels waiting to send by priority, taken from m_channel_send_queue, guarded by m_send_mutex
+        std::array<std::deque<net_base_channel*>, net_constants::CHANNEL_PRIORITY_LEVELS> m_scheduled_channels;
+        //channel whose quantum is charged for the data sent right now
+        net_base_channel* m_sending_channel = nullptr;
+
+        //congestion
+        net_mutex m_congestion_mutex;
+        std::unique_ptr<net_congestion_controller> m_congestion_controller;
 
         //fragment
         struct incoming_fragments {
@@ -77,12 +106,56 @@ namespace lnl {
 
         int32_t m_fragment_id = 0;
         std::unordered_map<uint16_t, incoming_fragments> m_holded_fragments;
+        net_mutex m_delivered_fragments_mutex;
         std::unordered_map<uint16_t, uint16_t> m_delivered_fragments;
 
         //merging
+        //guards the channel send pass and the merge buffer, which flush() may run on a user thread
+        net_mutex m_send_mutex;
         net_packet m_merge_data;
         size_t m_merge_pos = 0;
         int32_t m_merge_count = 0;
+        //merged packets rewritten as COMPACT_MERGED, guarded by m_send_mutex
+        net_packet m_compact_data;
+
+        //compression, guarded by m_send_mutex, the stats by their own mutex since the receive thread adds to them
+        net_lz_codec m_compressor;
+        std::vector<uint8_t> m_compression_buffer;
+        uint32_t m_compression_backoff = 0;
+        uint32_t m_compression_skip = 0;
+        net_mutex m_compression_stats_mutex;
+        net_compression_stats m_compression_stats;
+
+        //pacing, guarded by m_send_mutex
+        net_pacer m_pacer;
+        std::queue<net_packet*> m_paced_queue;
+
+        //channels with an ack waiting for ack_delay, guarded by m_send_mutex
+        std::vector<net_base_channel*> m_ack_channels;
+        int64_t m_ack_deadline = 0;
+        net_packet m_ack_buffer;
+
+        //forward error correction, the encoder is guarded by m_send_mutex, the decoder runs on the receive thread
+        net_fec_encoder m_fec_encoder;
+        net_packet m_fec_packet;
+        net_fec_decoder m_fec_decoder;
+
+        //share of net_manager::max_egress_rate, the credit is guarded by m_send_mutex, the weight is set by users
+        //and the blocked flag read by the logic thread without it
+        std::atomic<double> m_weight = 1.;
+        double m_egress_credit = 0.;
+        std::atomic<bool> m_egress_blocked = false;
+
+        //encryption, keyed once both salts are known, the seal buffer is guarded by m_send_mutex,
+        //opening and the replay window belong to the receive thread
+        uint64_t m_key_salt = 0;
+        std::unique_ptr<net_chacha20_poly1305> m_seal_cipher;
+        std::unique_ptr<net_chacha20_poly1305> m_open_cipher;
+        std::atomic<uint64_t> m_seal_nonce = 0;
+        std::vector<uint8_t> m_seal_buffer;
+        //one past the highest opened nonce, bit i of the window is that nonce minus i + 1
+        uint64_t m_open_nonce_next = 0;
+        uint64_t m_open_window = 0;
 
     protected:
         class net_manager* m_net_manager;
@@ -119,22 +192,73 @@ namespace lnl {
             return m_remote_id;
         }
 
-        inline void send(net_data_writer& writer, DELIVERY_METHOD deliveryMethod) {
-            send(writer, 0, deliveryMethod);
+        int32_t mtu() const {
+            return m_mtu;
+        }
+
+        [[nodiscard]] bool has_feature(PROTOCOL_FEATURE feature) const {
+            return m_extensions.has(feature);
+        }
+
+        //reliable window agreed on with the remote peer
+        [[nodiscard]] int32_t window_size(uint8_t channelNumber) const {
+            return m_extensions.window_size(channelNumber);
+        }
+
+        //immediate sends are sequenced, merged and sent on the calling thread instead of the next logic tick
+        inline void send(net_data_writer& writer, DELIVERY_METHOD deliveryMethod, bool immediate = false) {
+            send(writer, 0, deliveryMethod, immediate);
+        }
+
+        inline void send(net_data_writer& writer, uint8_t channelNumber, DELIVERY_METHOD deliveryMethod,
+                         bool immediate = false) {
+            send_internal(writer.data(), 0, writer.size(), channelNumber, deliveryMethod, nullptr, immediate);
         }
 
-        inline void send(net_data_writer& writer, uint8_t channelNumber, DELIVERY_METHOD deliveryMethod) {
-            send_internal(writer.data(), 0, writer.size(), channelNumber, deliveryMethod, nullptr);
+        inline void send(const std::vector<uint8_t>& buffer, DELIVERY_METHOD deliveryMethod, bool immediate = false) {
+            send(buffer, 0, deliveryMethod, immediate);
         }
 
-        inline void send(const std::vector<uint8_t>& buffer, DELIVERY_METHOD deliveryMethod) {
-            send(buffer, 0, deliveryMethod);
+        inline void send(const std::vector<uint8_t>& buffer, uint8_t channelNumber, DELIVERY_METHOD deliveryMethod,
+                         bool immediate = false) {
+            send_internal(buffer.data(), 0, buffer.size(), channelNumber, deliveryMethod, nullptr, immediate);
+        }
+
+        //reports the message through on_message_delivered once acked, and through on_message_lost
+        //if it was UNRELIABLE_NOTIFIED and no ack came in time, only reliable methods and UNRELIABLE_NOTIFIED
+        inline void send_with_delivery_event(net_data_writer& writer, uint8_t channelNumber,
+                                             DELIVERY_METHOD deliveryMethod, void* userData) {
+            send_with_delivery_event(writer.data(), 0, writer.size(), channelNumber, deliveryMethod, userData);
+        }
+
+        void send_with_delivery_event(const uint8_t* data, size_t offset, size_t size, uint8_t channelNumber,
+                                      DELIVERY_METHOD deliveryMethod, void* userData);
+
+        //sends a snapshot of the state under key as a delta against the newest snapshot of the key the peer acked,
+        //received with DELTA as the delivery method, unreliable like UNRELIABLE_NOTIFIED
+        inline void send_delta(net_data_writer& writer, uint16_t key, uint8_t channelNumber = 0) {
+            send_delta(writer.data(), 0, writer.size(), key, channelNumber);
+        }
+
+        void send_delta(const uint8_t* data, size_t offset, size_t size, uint16_t key, uint8_t channelNumber = 0);
+
+        //sends everything queued so far on the calling thread
+        void flush();
+
+        //relative share of the manager egress budget
+        [[nodiscard]] double weight() const {
+            return m_weight;
         }
 
-        inline void send(const std::vector<uint8_t>& buffer, uint8_t channelNumber, DELIVERY_METHOD deliveryMethod) {
-            send_internal(buffer.data(), 0, buffer.size(), channelNumber, deliveryMethod, nullptr);
+        void set_weight(double weight) {
+            m_weight = weight > 0. ? weight : 1.;
         }
 
+        //empty when the manager runs without congestion control
+        std::optional<net_congestion_state> congestion_state();
+
+        net_compression_stats compression_stats();
+
     private:
         DISCONNECT_RESULT process_disconnect(net_packet* packet);
 
@@ -144,11 +268,22 @@ namespace lnl {
 
         void process_packet(net_packet* packet);
 
+        void process_channeled_packet(net_packet* packet);
+
+        void process_compound_ack(net_packet* packet);
+
+        void process_piggybacked_ack(net_packet* packet);
+
+        void process_fec_packet(net_packet* packet);
+
+        void process_compressed_packet(net_packet* packet);
+
         void process_mtu_packet(net_packet* packet);
 
         void update_mtu_logic(int32_t deltaTime);
 
-        void update_roundtrip_time(int32_t roundTripTime);
+        //rtt sample in milliseconds, updates the resend delay
+        void update_roundtrip_time(double roundTripTime);
 
         void reject(std::unique_ptr<net_connect_request_packet>& requestData,
                     const std::optional<std::vector<uint8_t>>& rejectData,
@@ -162,35 +297,130 @@ namespace lnl {
         SHUTDOWN_RESULT shutdown(const std::optional<std::vector<uint8_t>>& rejectData,
                                  size_t offset, size_t size, bool force);
 
-        void reset_mtu() {
-            set_mtu(0);
-        }
+        //restarts discovery from the minimal mtu up to the largest candidate of the manager profile
+        void reset_mtu();
 
-        void set_mtu(size_t mtuIdx) {
-            m_mtu_idx = mtuIdx;
-            m_mtu = net_constants::POSSIBLE_MTU[mtuIdx];
-        }
+        //the candidate is the datagram size, packets get what the manager packet layers leave of it
+        void set_mtu(size_t mtuIdx);
+
+        //basic channel ids count up from 0 and extended ones down from 255, -1 when a basic channel has the id
+        [[nodiscard]] int32_t get_channel_id(uint8_t channelNumber, DELIVERY_METHOD method) const;
+
+        [[nodiscard]] uint8_t get_channel_number(uint8_t channelId) const;
+
+        [[nodiscard]] DELIVERY_METHOD get_channel_method(uint8_t channelId) const;
 
         net_base_channel* create_channel(uint8_t idx);
 
+        bool congestion_can_send(size_t bytes);
+
+        void congestion_on_sent(size_t bytes, int64_t currentTime);
+
+        void congestion_on_acked(size_t bytes, int64_t rtt, int64_t currentTime);
+
+        void congestion_on_lost(size_t bytes, int64_t sentTime, int64_t currentTime);
+
         void add_reliable_packet(DELIVERY_METHOD method, net_packet* packet);
 
+        //raises a receive event for every message of a bundled reliable packet
+        void deliver_bundle(DELIVERY_METHOD method, net_packet* packet);
+
         void clear_holded_fragments(uint16_t fragmentId);
 
         void send_user_data(net_packet* packet);
 
         void send_merged();
 
-        void recycle_and_deliver(net_packet* packet);
+        [[nodiscard]] bool is_fec_protected(const net_packet* packet) const;
+
+        void send_fec_protected(net_packet* packet);
+
+        void queue_ack(net_base_channel* channel);
+
+        void dequeue_ack(net_base_channel* channel);
+
+        //channel of a data packet that can carry its queued ack
+        net_base_channel* get_piggyback_channel(const net_packet* packet) const;
+
+        //sends the acks of all queued channels once the ack delay has passed, in one packet with compound acks
+        void send_queued_acks(int64_t currentTime);
+
+        //every datagram of the send pass goes through here so it can be compressed and paced
+        void send_datagram(const uint8_t* data, size_t offset, size_t size);
+
+        //writes the datagram as COMPRESSED into m_compression_buffer, returns its size or 0 to send it as it is
+        size_t compress_datagram(const uint8_t* data, size_t size);
+
+        //channel number whose dictionary compresses the datagram, -1 if it doesn't start with channel data
+        int32_t get_dictionary_channel(const uint8_t* data, size_t size) const;
 
-        void add_to_reliable_channel_send_queue(net_base_channel* channel) {
-            m_channel_send_queue.push(channel);
+        //packets sent in the clear are the ones exchanged before the keys or without a peer
+        static bool is_sealed(PACKET_PROPERTY property);
+
+        //derives the key from both salts, each direction gets its own nonce prefix
+        void init_encryption(uint64_t requestSalt, uint64_t acceptSalt, bool accepting);
+
+        //writes [first byte][encrypted rest][tag][nonce u32] into dst, returns its size
+        size_t seal_datagram(const uint8_t* data, size_t size, uint8_t* dst);
+
+        //send_raw for packets outside of the send pass, sealed when the peer has keys
+        int32_t send_sealed(const uint8_t* data, size_t offset, size_t size);
+
+        int32_t send_sealed(const net_packet* packet) {
+            return send_sealed(packet->data(), 0, packet->size());
         }
 
+        //false when the packet can't be a sealed datagram of this peer
+        bool make_open_job(net_packet* packet, net_aead_job& job);
+
+        //replay check of an opened datagram, marks its nonce as seen
+        bool accept_nonce(uint64_t nonce);
+
+        //adds the cookie to the connect request and sends it again right away
+        void process_connect_challenge(net_packet* packet);
+
+        void update_pacing_rate();
+
+        void send_paced(int64_t currentTime);
+
+        void schedule_pacing_wakeup(size_t bytes);
+
+        //wakes the logic thread after delay ticks instead of the next update
+        void schedule_wakeup(int64_t delay);
+
+        [[nodiscard]] bool has_egress_credit() const;
+
+        //egress credit and nothing waiting for the pacer, the send pass stops without it, guarded by m_send_mutex
+        [[nodiscard]] bool has_send_room() const;
+
+        //adds to the egress credit, keeping at most maxCredit
+        void add_egress_credit(double credit, double maxCredit);
+
+        //takes the credit above `reserve` away, returns how much was taken
+        double take_unused_egress_credit(double reserve);
+
+        //the last send pass ran out of egress credit, waiting for the pacer doesn't count
+        [[nodiscard]] bool is_egress_blocked() const {
+            return m_egress_blocked;
+        }
+
+        void recycle_and_deliver(net_packet* packet);
+
+        void add_to_reliable_channel_send_queue(net_base_channel* channel);
+
         void update(int32_t deltaTime);
 
+        //sends everything queued in channels and merges it, without touching timers
+        void process_send_queues();
+
+        //deficit round robin over the channels of one priority
+        void send_scheduled(std::deque<net_base_channel*>& channels);
+
+        //sends unreliable packets until about quota bytes went out, at least one when there is room
+        void send_unreliable(size_t quota);
+
         void send_internal(const uint8_t* data, size_t offset, size_t size, uint8_t channelNumber,
-                           DELIVERY_METHOD deliveryMethod, void* userData);
+                           DELIVERY_METHOD deliveryMethod, void* userData, bool immediate);
 
         friend class net_manager;
 
@@ -199,5 +429,11 @@ namespace lnl {
         friend class net_reliable_channel;
 
         friend class net_sequenced_channel;
+
+        friend class net_redundant_channel;
+
+        friend class net_notified_channel;
+
+        friend class net_delta_channel;
     };
 }
\ No newline at end of file
@@ -27,6 +27,16 @@ namespace lnl {
             return m_queue.size();
         }
 
+        std::optional<T> peek() const {
+            net_mutex_guard guard(m_mutex);
+
+            if (m_queue.empty()) {
+                return {};
+            }
+
+            return std::optional<T>(m_queue.front());
+        }
+
         std::optional<T> dequeue() {
             net_mutex_guard guard(m_mutex);
 
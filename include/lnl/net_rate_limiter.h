@@ -0,0 +1,42 @@
+#pragma once
+
+#include <lnl/net_utils.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lnl {
+    //token buckets of any number of sources in fixed memory, rate in tokens per second, times in ticks
+    //a count-min sketch of spent tokens: every source owns one cell per row, the cells leak at the rate and the
+    //least spent one stands for the source, so sharing cells with busy sources may limit it early but never late
+    class net_rate_limiter final {
+        static constexpr size_t DEPTH = 4;
+        //the whole table leaks at once, no more often than this
+        static constexpr int64_t DECAY_INTERVAL = 10 * TICKS_PER_MILLISECOND;
+
+        std::vector<float> m_cells;
+        size_t m_width;
+        std::array<uint64_t, DEPTH> m_seeds{};
+        double m_rate = 0.;
+        double m_burst = 0.;
+        int64_t m_last_decay = 0;
+
+        void decay(int64_t currentTime);
+
+    public:
+        //width is rounded up to a power of two
+        explicit net_rate_limiter(size_t width = 1024);
+
+        [[nodiscard]] bool enabled() const {
+            return m_rate > 0.;
+        }
+
+        //forgets what was spent, 0 disables
+        void set_rate(double rate, double burst);
+
+        //takes a token from the bucket of key when it has one
+        bool try_acquire(uint64_t key, int64_t currentTime);
+    };
+}
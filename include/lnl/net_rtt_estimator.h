@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace lnl {
+    //smoothed rtt and rtt variance as in RFC 6298, all values in milliseconds
+    class net_rtt_estimator final {
+        static constexpr double ALPHA = 1. / 8.;
+        static constexpr double BETA = 1. / 4.;
+        static constexpr double VARIANCE_FACTOR = 4.;
+
+        double m_srtt = 0.;
+        double m_rttvar = 0.;
+        bool m_has_sample = false;
+
+    public:
+        [[nodiscard]] bool has_sample() const {
+            return m_has_sample;
+        }
+
+        [[nodiscard]] double srtt() const {
+            return m_srtt;
+        }
+
+        [[nodiscard]] double rttvar() const {
+            return m_rttvar;
+        }
+
+        void add_sample(double rtt) {
+            if (!m_has_sample) {
+                m_srtt = rtt;
+                m_rttvar = rtt / 2.;
+                m_has_sample = true;
+                return;
+            }
+
+            m_rttvar = (1. - BETA) * m_rttvar + BETA * std::abs(m_srtt - rtt);
+            m_srtt = (1. - ALPHA) * m_srtt + ALPHA * rtt;
+        }
+
+        //granularity is how often expired timers are checked
+        [[nodiscard]] double rto(double granularity, double minRto, double maxRto) const {
+            return std::clamp(m_srtt + std::max(granularity, VARIANCE_FACTOR * m_rttvar), minRto, maxRto);
+        }
+    };
+}
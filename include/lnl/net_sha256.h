@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    class net_sha256 final {
+    public:
+        static constexpr size_t DIGEST_SIZE = 32;
+        static constexpr size_t BLOCK_SIZE = 64;
+
+    private:
+        std::array<uint32_t, 8> m_state;
+        std::array<uint8_t, BLOCK_SIZE> m_buffer{};
+        size_t m_buffered = 0;
+        uint64_t m_total = 0;
+
+        void compress(const uint8_t* block);
+
+    public:
+        net_sha256();
+
+        void update(const uint8_t* data, size_t size);
+
+        void finish(uint8_t* digest);
+    };
+
+    //rfc 2104, keys longer than a block are hashed first
+    void hmac_sha256(const uint8_t* key, size_t keySize, const uint8_t* data, size_t size, uint8_t* mac);
+}
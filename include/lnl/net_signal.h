@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifdef WIN32
+#include <Windows.h>
+#elif __linux__
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#endif
+
+namespace lnl {
+    //wakes a sleeping thread either when notify() is called or when the deadline passes
+    //on linux this is an eventfd paired with a timerfd, so deadlines are not rounded to milliseconds
+    class net_signal final {
+#ifdef WIN32
+        HANDLE m_event = nullptr;
+#elif __linux__
+        int m_event_fd = -1;
+        int m_timer_fd = -1;
+#endif
+        std::atomic<bool> m_pending = false;
+    public:
+        using clock = std::chrono::steady_clock;
+
+        net_signal() {
+#ifdef WIN32
+            m_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+#elif __linux__
+            m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#endif
+        }
+
+        net_signal(const net_signal&) = delete;
+
+        net_signal& operator=(const net_signal&) = delete;
+
+        ~net_signal() {
+#ifdef WIN32
+            CloseHandle(m_event);
+#elif __linux__
+            close(m_event_fd);
+            close(m_timer_fd);
+#endif
+        }
+
+#ifdef __linux__
+
+        //can be added to a poll set to interrupt other blocking waits
+        [[nodiscard]] int native_handle() const {
+            return m_event_fd;
+        }
+
+#endif
+
+        void notify() {
+            //only the first notify after a wakeup goes to the kernel
+            if (m_pending.exchange(true)) {
+                return;
+            }
+
+#ifdef WIN32
+            SetEvent(m_event);
+#elif __linux__
+            uint64_t value = 1;
+            (void) !write(m_event_fd, &value, sizeof(value));
+#endif
+        }
+
+        //returns true if woken by notify(), false if the deadline passed
+        bool wait_until(clock::time_point deadline) {
+            auto notified = false;
+
+#ifdef WIN32
+            auto now = clock::now();
+            DWORD timeout = 0;
+
+            if (deadline > now) {
+                //round up, otherwise we'd spin until the deadline
+                timeout = (DWORD) std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+            }
+
+            notified = WaitForSingleObject(m_event, timeout) == WAIT_OBJECT_0;
+#elif __linux__
+            auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+            struct itimerspec spec{};
+            spec.it_value.tv_sec = (time_t) (sinceEpoch.count() / 1000000000);
+            spec.it_value.tv_nsec = (long) (sinceEpoch.count() % 1000000000);
+
+            if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+                //zero would disarm the timer
+                spec.it_value.tv_nsec = 1;
+            }
+
+            timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+            struct pollfd pollfds[2];
+            pollfds[0].fd = m_event_fd;
+            pollfds[0].events = POLLIN;
+            pollfds[1].fd = m_timer_fd;
+            pollfds[1].events = POLLIN;
+
+            if (poll(pollfds, 2, -1) > 0) {
+                uint64_t value;
+
+                if (pollfds[0].revents & POLLIN) {
+                    notified = true;
+                    (void) !read(m_event_fd, &value, sizeof(value));
+                }
+
+                if (pollfds[1].revents & POLLIN) {
+                    (void) !read(m_timer_fd, &value, sizeof(value));
+                }
+            }
+#endif
+
+            m_pending = false;
+
+            return notified;
+        }
+    };
+}
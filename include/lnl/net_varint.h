@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lnl {
+    //7 bits per byte, least significant first, the high bit marks a following byte
+    inline bool write_varint(uint8_t* dst, size_t capacity, size_t& pos, size_t value) {
+        do {
+            if (pos >= capacity) {
+                return false;
+            }
+
+            dst[pos++] = (uint8_t) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+            value >>= 7;
+        } while (value != 0);
+
+        return true;
+    }
+
+    inline bool read_varint(const uint8_t* src, size_t size, size_t& pos, size_t& value) {
+        value = 0;
+
+        for (size_t shift = 0; shift < 32; shift += 7) {
+            if (pos >= size) {
+                return false;
+            }
+
+            auto byte = src[pos++];
+            value |= (size_t) (byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    [[nodiscard]] inline size_t varint_size(size_t value) {
+        size_t size = 1;
+
+        for (; value > 0x7F; value >>= 7) {
+            size++;
+        }
+
+        return size;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#endif
+
+namespace lnl {
+    //dst ^= src over size bytes, neither side needs to be aligned
+    inline void xor_into(uint8_t* dst, const uint8_t* src, size_t size) {
+        size_t pos = 0;
+
+#if defined(__AVX2__)
+        for (; pos + 32 <= size; pos += 32) {
+            auto a = _mm256_loadu_si256((const __m256i*) &dst[pos]);
+            auto b = _mm256_loadu_si256((const __m256i*) &src[pos]);
+            _mm256_storeu_si256((__m256i*) &dst[pos], _mm256_xor_si256(a, b));
+        }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+        for (; pos + 16 <= size; pos += 16) {
+            auto a = _mm_loadu_si128((const __m128i*) &dst[pos]);
+            auto b = _mm_loadu_si128((const __m128i*) &src[pos]);
+            _mm_storeu_si128((__m128i*) &dst[pos], _mm_xor_si128(a, b));
+        }
+#endif
+
+        for (; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+            uint64_t a;
+            uint64_t b;
+            memcpy(&a, &dst[pos], sizeof(a));
+            memcpy(&b, &src[pos], sizeof(b));
+            a ^= b;
+            memcpy(&dst[pos], &a, sizeof(a));
+        }
+
+        for (; pos < size; ++pos) {
+            dst[pos] ^= src[pos];
+        }
+    }
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <lnl/net_packet.h>
+#include <lnl/packets/net_connect_extensions.h>
 #include <memory>
+#include <optional>
 
 namespace lnl {
     class net_connect_accept_packet final {
@@ -9,13 +11,16 @@ namespace lnl {
         uint8_t m_connection_number;
         int32_t m_peer_id;
         bool m_peer_network_changed;
+        net_connect_extensions m_extensions;
 
     public:
         net_connect_accept_packet(int64_t connectionTime, uint8_t connectionNumber, int32_t peerId,
-                                  bool peerNetworkChanged) : m_connection_time(connectionTime),
-                                                             m_connection_number(connectionNumber),
-                                                             m_peer_id(peerId),
-                                                             m_peer_network_changed(peerNetworkChanged) {}
+                                  bool peerNetworkChanged,
+                                  const net_connect_extensions& extensions = {}) : m_connection_time(connectionTime),
+                                                                                   m_connection_number(connectionNumber),
+                                                                                   m_peer_id(peerId),
+                                                                                   m_peer_network_changed(peerNetworkChanged),
+                                                                                   m_extensions(extensions) {}
 
         [[nodiscard]] int64_t connection_time() const {
             return m_connection_time;
@@ -33,7 +38,14 @@ namespace lnl {
             return m_peer_network_changed;
         }
 
-        static net_packet* make(int64_t connectTime, uint8_t connectNum, int32_t localPeerId);
+        //features the accepting side agreed to, empty when it sent no extensions
+        [[nodiscard]] const net_connect_extensions& extensions() const {
+            return m_extensions;
+        }
+
+        //extensions are only appended when the request carried them
+        static net_packet* make(int64_t connectTime, uint8_t connectNum, int32_t localPeerId,
+                                const std::optional<net_connect_extensions>& extensions = std::nullopt);
 
         static net_packet* make_network_changed(class net_peer* peer);
 
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <lnl/net_enums.h>
+#include <lnl/net_packet.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace lnl {
+    //optional trailer of CONNECT_REQUEST and CONNECT_ACCEPT, present when EXTENSION_FLAG is set
+    //layout: [record type u8][record size u8][record]... [trailer size u16]
+    //peers without extensions never set the flag, so features are only used when both sides offer them
+    class net_connect_extensions final {
+        enum class RECORD_TYPE : uint8_t {
+            FEATURES,
+            KEY_SALT,
+            COOKIE,
+            WINDOW_SIZES
+        };
+
+        static constexpr size_t RECORD_HEADER_SIZE = 2;
+        static constexpr size_t TRAILER_SIZE_FIELD = sizeof(uint16_t);
+
+    public:
+        //the fragmented bit, never set on connect packets otherwise
+        static constexpr uint8_t EXTENSION_FLAG = 0x80;
+
+        uint32_t features = 0;
+        //random per connection and side, the encryption key is derived from both, 0 when not sent
+        uint64_t key_salt = 0;
+        //echoed from CONNECT_CHALLENGE
+        std::optional<std::array<uint8_t, net_constants::CONNECT_COOKIE_SIZE>> cookie;
+        //reliable window of every channel number in DEFAULT_WINDOW_SIZE units, powers of two, later channels use the default
+        std::vector<uint8_t> window_sizes;
+
+        [[nodiscard]] bool has(PROTOCOL_FEATURE feature) const {
+            return (features & (1u << (uint8_t) feature)) != 0;
+        }
+
+        void set(PROTOCOL_FEATURE feature) {
+            features |= 1u << (uint8_t) feature;
+        }
+
+        [[nodiscard]] int32_t window_size(uint8_t channelNumber) const {
+            if (channelNumber >= window_sizes.size()) {
+                return net_constants::DEFAULT_WINDOW_SIZE;
+            }
+
+            return window_sizes[channelNumber] * net_constants::DEFAULT_WINDOW_SIZE;
+        }
+
+        //both sides end up with the smaller window of each channel
+        [[nodiscard]] net_connect_extensions intersect(const net_connect_extensions& other) const {
+            net_connect_extensions result;
+            result.features = features & other.features;
+            result.window_sizes.resize(std::max(window_sizes.size(), other.window_sizes.size()));
+
+            for (size_t i = 0; i < result.window_sizes.size(); ++i) {
+                result.window_sizes[i] = (uint8_t) (std::min(window_size((uint8_t) i),
+                                                             other.window_size((uint8_t) i)) /
+                                                    net_constants::DEFAULT_WINDOW_SIZE);
+            }
+
+            return result;
+        }
+
+        [[nodiscard]] size_t size() const {
+            auto result = RECORD_HEADER_SIZE + sizeof(features) + TRAILER_SIZE_FIELD;
+
+            if (key_salt != 0) {
+                result += RECORD_HEADER_SIZE + sizeof(key_salt);
+            }
+
+            if (cookie) {
+                result += RECORD_HEADER_SIZE + cookie->size();
+            }
+
+            if (!window_sizes.empty()) {
+                result += RECORD_HEADER_SIZE + window_sizes.size();
+            }
+
+            return result;
+        }
+
+        //appends the trailer and flags the packet
+        void write_to(net_packet* packet) const {
+            auto pos = packet->size();
+            packet->resize(pos + size());
+
+            packet->data()[pos] = (uint8_t) RECORD_TYPE::FEATURES;
+            packet->data()[pos + 1] = (uint8_t) sizeof(features);
+            packet->set_value_at(features, pos + RECORD_HEADER_SIZE);
+            pos += RECORD_HEADER_SIZE + sizeof(features);
+
+            if (key_salt != 0) {
+                packet->data()[pos] = (uint8_t) RECORD_TYPE::KEY_SALT;
+                packet->data()[pos + 1] = (uint8_t) sizeof(key_salt);
+                packet->set_value_at(key_salt, pos + RECORD_HEADER_SIZE);
+                pos += RECORD_HEADER_SIZE + sizeof(key_salt);
+            }
+
+            if (cookie) {
+                packet->data()[pos] = (uint8_t) RECORD_TYPE::COOKIE;
+                packet->data()[pos + 1] = (uint8_t) cookie->size();
+                packet->copy_from(cookie->data(), 0, pos + RECORD_HEADER_SIZE, cookie->size());
+                pos += RECORD_HEADER_SIZE + cookie->size();
+            }
+
+            if (!window_sizes.empty()) {
+                packet->data()[pos] = (uint8_t) RECORD_TYPE::WINDOW_SIZES;
+                packet->data()[pos + 1] = (uint8_t) window_sizes.size();
+                packet->copy_from(window_sizes.data(), 0, pos + RECORD_HEADER_SIZE, window_sizes.size());
+                pos += RECORD_HEADER_SIZE + window_sizes.size();
+            }
+
+            packet->set_value_at((uint16_t) size(), pos);
+            packet->data()[0] |= EXTENSION_FLAG;
+        }
+
+        //trailerSize receives the bytes to strip from the end, empty result means malformed trailer
+        static std::optional<net_connect_extensions> read_from(const net_packet* packet, size_t headerSize,
+                                                               size_t& trailerSize) {
+            trailerSize = 0;
+            net_connect_extensions result;
+
+            if ((packet->data()[0] & EXTENSION_FLAG) == 0) {
+                return result;
+            }
+
+            if (packet->size() < headerSize + TRAILER_SIZE_FIELD) {
+                return std::nullopt;
+            }
+
+            auto size = (size_t) packet->get_value_at<uint16_t>(packet->size() - TRAILER_SIZE_FIELD);
+
+            if (size < TRAILER_SIZE_FIELD || size > packet->size() - headerSize) {
+                return std::nullopt;
+            }
+
+            auto pos = packet->size() - size;
+            auto end = packet->size() - TRAILER_SIZE_FIELD;
+
+            while (pos < end) {
+                if (end - pos < RECORD_HEADER_SIZE) {
+                    return std::nullopt;
+                }
+
+                auto type = (RECORD_TYPE) packet->data()[pos];
+                size_t recordSize = packet->data()[pos + 1];
+                pos += RECORD_HEADER_SIZE;
+
+                if (end - pos < recordSize) {
+                    return std::nullopt;
+                }
+
+                //unknown records come from newer peers and are skipped
+                if (type == RECORD_TYPE::FEATURES && recordSize >= sizeof(result.features)) {
+                    result.features = packet->get_value_at<uint32_t>(pos);
+                } else if (type == RECORD_TYPE::KEY_SALT && recordSize >= sizeof(result.key_salt)) {
+                    result.key_salt = packet->get_value_at<uint64_t>(pos);
+                } else if (type == RECORD_TYPE::COOKIE && recordSize == net_constants::CONNECT_COOKIE_SIZE) {
+                    result.cookie.emplace();
+                    memcpy(result.cookie->data(), &packet->data()[pos], recordSize);
+                } else if (type == RECORD_TYPE::WINDOW_SIZES) {
+                    result.window_sizes.assign(&packet->data()[pos], &packet->data()[pos + recordSize]);
+
+                    //a window the bitmaps can't hold or that doesn't divide MAX_SEQUENCE is malformed
+                    for (auto& windowSize: result.window_sizes) {
+                        if (windowSize == 0 || (windowSize & (windowSize - 1)) != 0 ||
+                            windowSize > net_constants::MAX_WINDOW_SIZE / net_constants::DEFAULT_WINDOW_SIZE) {
+                            return std::nullopt;
+                        }
+                    }
+                }
+
+                pos += recordSize;
+            }
+
+            trailerSize = size;
+            return result;
+        }
+    };
+}
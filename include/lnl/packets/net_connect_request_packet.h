@@ -7,6 +7,7 @@
 #include <lnl/net_data_writer.h>
 #include <lnl/net_packet.h>
 #include <lnl/net_address.h>
+#include <lnl/packets/net_connect_extensions.h>
 
 namespace lnl {
     class net_connect_request_packet final {
@@ -17,6 +18,8 @@ namespace lnl {
         net_data_reader data;
         int32_t peer_id;
         net_packet* packet;
+        //empty when the requesting side sent no extensions
+        std::optional<net_connect_extensions> extensions;
 
         net_connect_request_packet(int64_t connectionTime,
                                    uint8_t connectionNumber,
@@ -50,13 +53,28 @@ namespace lnl {
                 return nullptr;
             }
 
+            size_t trailerSize;
+            auto extensions = net_connect_extensions::read_from(packet,
+                                                                net_constants::CONNECT_REQUEST_HEADER_SIZE + addrSize,
+                                                                trailerSize);
+
+            if (!extensions) {
+                return nullptr;
+            }
+
             net_address targetAddress(*(sockaddr_in*) &packet->data()[net_constants::CONNECT_REQUEST_HEADER_SIZE]);
-            net_data_reader reader(packet->data(), packet->size(),
+            net_data_reader reader(packet->data(), packet->size() - trailerSize,
                                    net_constants::CONNECT_REQUEST_HEADER_SIZE + addrSize);
 
 
-            return std::make_unique<net_connect_request_packet>(connectionTime, packet->connection_number(),
-                                                                targetAddress, reader, peerId, packet);
+            auto result = std::make_unique<net_connect_request_packet>(connectionTime, packet->connection_number(),
+                                                                       targetAddress, reader, peerId, packet);
+
+            if (trailerSize > 0) {
+                result->extensions = *extensions;
+            }
+
+            return result;
         }
 
         static net_packet* make(const net_data_writer& connectData, const net_address& address, int64_t connectTime,
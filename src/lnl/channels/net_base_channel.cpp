@@ -6,12 +6,31 @@ void lnl::net_base_channel::add_to_peer_channel_send_queue() {
 #ifdef WIN32
     if (InterlockedCompareExchange(&m_is_added_to_peer_channel_send_queue, 1, 0) == 0) {
         m_peer->add_to_reliable_channel_send_queue(this);
+        return;
     }
 #elif __linux__
     if (__sync_val_compare_and_swap(&m_is_added_to_peer_channel_send_queue, 0, 1) == 0) {
         m_peer->add_to_reliable_channel_send_queue(this);
+        return;
     }
 #endif
+
+    //already queued, but the logic thread may be sleeping until the next tick
+    m_peer->m_net_manager->wake_logic_thread();
+}
+
+bool lnl::net_base_channel::has_send_quota() const {
+    return m_deficit > 0 && m_peer->has_send_room();
+}
+
+void lnl::net_base_channel::send_ack(lnl::net_packet* ack) {
+    if (m_peer->m_extensions.has(PROTOCOL_FEATURE::COMPOUND_ACK) ||
+        m_peer->m_extensions.has(PROTOCOL_FEATURE::PIGGYBACK_ACK)) {
+        m_peer->queue_ack(this);
+        return;
+    }
+
+    m_peer->send_user_data(ack);
 }
 
 lnl::net_base_channel::~net_base_channel() {
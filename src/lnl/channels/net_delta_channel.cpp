@@ -0,0 +1,197 @@
+#include <lnl/channels/net_delta_channel.h>
+#include <lnl/net_peer.h>
+#include <lnl/net_manager.h>
+
+#include <algorithm>
+
+void lnl::net_delta_channel::send(const uint8_t* data, size_t offset, size_t size, uint16_t key) {
+    static constexpr size_t HEADER_SIZE = net_constants::CHANNELED_HEADER_SIZE + net_constants::DELTA_HEADER_SIZE;
+
+    auto packet = m_peer->m_net_manager->pool_get_packet(HEADER_SIZE + size);
+    auto sent = new sent_snapshot{key, {0, std::vector<uint8_t>(&data[offset], &data[offset + size])}};
+
+    {
+        net_mutex_guard guard(m_outgoing_mutex);
+        auto& outgoing = m_outgoing_keys[key];
+        auto& baseline = outgoing.baseline;
+
+        sent->value.version = outgoing.next_version;
+        outgoing.next_version = (outgoing.next_version + 1) % net_constants::MAX_SEQUENCE;
+
+        size_t encodedSize = 0;
+
+        //a delta larger than the snapshot is never used
+        if (baseline && relative_sequence_number(sent->value.version, baseline->version) < HISTORY_SIZE &&
+            m_codec.encode(baseline->data.data(), baseline->data.size(),
+                           &data[offset], size,
+                           &packet->data()[HEADER_SIZE], size, encodedSize)) {
+            packet->set_value_at(baseline->version, net_constants::CHANNELED_HEADER_SIZE + 4);
+        } else {
+            packet->copy_from(data, offset, HEADER_SIZE, size);
+            packet->set_value_at(NO_BASELINE, net_constants::CHANNELED_HEADER_SIZE + 4);
+            encodedSize = size;
+        }
+
+        packet->resize(HEADER_SIZE + encodedSize);
+    }
+
+    packet->set_property(PACKET_PROPERTY::CHANNELED);
+    packet->set_value_at(key, net_constants::CHANNELED_HEADER_SIZE);
+    packet->set_value_at(sent->value.version, net_constants::CHANNELED_HEADER_SIZE + 2);
+    packet->set_value_at((uint16_t) size, net_constants::CHANNELED_HEADER_SIZE + 6);
+    packet->user_data = sent;
+
+    add_to_queue(packet);
+}
+
+bool lnl::net_delta_channel::deliver(lnl::net_packet* packet) {
+    static constexpr size_t HEADER_SIZE = net_constants::CHANNELED_HEADER_SIZE + net_constants::DELTA_HEADER_SIZE;
+
+    if (packet->size() < HEADER_SIZE) {
+        return false;
+    }
+
+    auto key = packet->get_value_at<uint16_t>(net_constants::CHANNELED_HEADER_SIZE);
+    auto version = packet->get_value_at<uint16_t>(net_constants::CHANNELED_HEADER_SIZE + 2);
+    auto baselineVersion = packet->get_value_at<uint16_t>(net_constants::CHANNELED_HEADER_SIZE + 4);
+    auto size = packet->get_value_at<uint16_t>(net_constants::CHANNELED_HEADER_SIZE + 6);
+    auto src = &packet->data()[HEADER_SIZE];
+    auto srcSize = packet->size() - HEADER_SIZE;
+
+    if (version >= net_constants::MAX_SEQUENCE || size > m_peer->m_net_manager->max_packet_size()) {
+        return false;
+    }
+
+    //nothing is kept for a key before one of its snapshots was delivered
+    auto it = m_incoming_keys.find(key);
+    const snapshot* baseline = nullptr;
+
+    if (baselineVersion != NO_BASELINE) {
+        if (it == m_incoming_keys.end()) {
+            return false;
+        }
+
+        for (auto& received: it->second.history) {
+            if (received.version == baselineVersion) {
+                baseline = &received;
+                break;
+            }
+        }
+
+        if (!baseline) {
+            return false;
+        }
+    } else if (srcSize != size) {
+        return false;
+    }
+
+    auto message = m_peer->m_net_manager->pool_get_packet(net_constants::CHANNELED_HEADER_SIZE + size);
+    auto dst = &message->data()[net_constants::CHANNELED_HEADER_SIZE];
+
+    if (!baseline) {
+        memcpy(dst, src, size);
+    } else if (!net_delta_codec::decode(baseline->data.data(), baseline->data.size(), src, srcSize, dst, size)) {
+        m_peer->m_net_manager->pool_recycle(message);
+        return false;
+    }
+
+    if (it == m_incoming_keys.end()) {
+        it = m_incoming_keys.emplace(key, incoming_key{}).first;
+    }
+
+    auto& incoming = it->second;
+    auto& history = incoming.history;
+    incoming.last_use = ++m_incoming_uses;
+
+    //the sender only moves its baseline forward, older snapshots are never referenced again
+    if (baseline) {
+        auto oldest = baselineVersion;
+        auto& bytes = m_incoming_bytes;
+        history.erase(std::remove_if(history.begin(), history.end(), [oldest, &bytes](const snapshot& received) {
+            if (relative_sequence_number(received.version, oldest) >= 0) {
+                return false;
+            }
+
+            bytes -= received.data.size();
+            return true;
+        }), history.end());
+    }
+
+    if (history.size() >= HISTORY_SIZE) {
+        m_incoming_bytes -= history.front().data.size();
+        history.pop_front();
+    }
+
+    history.push_back({version, std::vector<uint8_t>(dst, dst + size)});
+    m_incoming_bytes += size;
+
+    forget_incoming_keys(key);
+
+    message->set_property(PACKET_PROPERTY::CHANNELED);
+    m_peer->m_net_manager->create_receive_event(message,
+                                                DELIVERY_METHOD::DELTA,
+                                                m_peer->get_channel_number(m_id),
+                                                net_constants::CHANNELED_HEADER_SIZE,
+                                                m_peer->m_endpoint);
+    m_peer->m_net_manager->pool_recycle(packet);
+
+    return true;
+}
+
+void lnl::net_delta_channel::forget_incoming_keys(uint16_t keep) {
+    while (m_incoming_keys.size() > MAX_INCOMING_KEYS || m_incoming_bytes > MAX_INCOMING_BYTES) {
+        auto oldest = m_incoming_keys.end();
+
+        for (auto it = m_incoming_keys.begin(); it != m_incoming_keys.end(); ++it) {
+            if (it->first == keep) {
+                continue;
+            }
+
+            if (oldest == m_incoming_keys.end() || it->second.last_use < oldest->second.last_use) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == m_incoming_keys.end()) {
+            return;
+        }
+
+        for (auto& received: oldest->second.history) {
+            m_incoming_bytes -= received.data.size();
+        }
+
+        m_incoming_keys.erase(oldest);
+    }
+}
+
+void lnl::net_delta_channel::on_delivered(void* userData) {
+    auto sent = (sent_snapshot*) userData;
+
+    {
+        net_mutex_guard guard(m_outgoing_mutex);
+        auto& baseline = m_outgoing_keys[sent->key].baseline;
+
+        if (!baseline || relative_sequence_number(sent->value.version, baseline->version) > 0) {
+            baseline = std::move(sent->value);
+        }
+    }
+
+    delete sent;
+}
+
+void lnl::net_delta_channel::on_lost(void* userData) {
+    delete (sent_snapshot*) userData;
+}
+
+lnl::net_delta_channel::~net_delta_channel() {
+    clear_pending([](void* userData) {
+        delete (sent_snapshot*) userData;
+    });
+
+    std::optional<net_packet*> packet;
+
+    while ((packet = m_outgoing_queue.dequeue())) {
+        delete (sent_snapshot*) packet.value()->user_data;
+        m_peer->m_net_manager->pool_recycle(packet.value());
+    }
+}
@@ -0,0 +1,216 @@
+#include <lnl/channels/net_notified_channel.h>
+#include <lnl/net_peer.h>
+#include <lnl/net_manager.h>
+#include <lnl/net_utils.h>
+
+#include <algorithm>
+
+bool lnl::net_notified_channel::process_packet(lnl::net_packet* packet) {
+    if (packet->property() == PACKET_PROPERTY::ACK) {
+        process_ack(packet);
+        return false;
+    }
+
+    auto seq = packet->sequence();
+
+    if (packet->is_fragmented() || seq >= net_constants::MAX_SEQUENCE) {
+        return false;
+    }
+
+    auto relate = relative_sequence_number(seq, m_remote_window_start);
+
+    //older than the window, its ack is no longer sent so it's reported lost
+    if (relate < 0) {
+        return false;
+    }
+
+    {
+        net_mutex_guard guard(m_outgoing_acks_mutex);
+
+        if (relate >= m_window_size) {
+            int32_t newWindowStart = (m_remote_window_start + relate - m_window_size + 1) % net_constants::MAX_SEQUENCE;
+            m_outgoing_acks.set_sequence(newWindowStart);
+
+            bitmap_clear_circular(&m_outgoing_acks.data()[net_constants::CHANNELED_HEADER_SIZE],
+                                  m_window_size,
+                                  m_remote_window_start % m_window_size,
+                                  std::min(relative_sequence_number(newWindowStart, m_remote_window_start),
+                                           m_window_size));
+            m_remote_window_start = newWindowStart;
+        }
+
+        m_must_send_acks = true;
+
+        auto ackIdx = seq % m_window_size;
+        auto ackByte = net_constants::CHANNELED_HEADER_SIZE + ackIdx / BITS_IN_BYTE;
+        auto ackBit = ackIdx % BITS_IN_BYTE;
+
+        if ((m_outgoing_acks.data()[ackByte] & (1 << ackBit)) != 0) {
+            add_to_peer_channel_send_queue();
+            return false;
+        }
+    }
+
+    //a packet that could not be delivered is not acked
+    if (!deliver(packet)) {
+        return false;
+    }
+
+    {
+        net_mutex_guard guard(m_outgoing_acks_mutex);
+        auto ackIdx = seq % m_window_size;
+        m_outgoing_acks.data()[net_constants::CHANNELED_HEADER_SIZE + ackIdx / BITS_IN_BYTE] |=
+                (uint8_t) (1 << (ackIdx % BITS_IN_BYTE));
+    }
+
+    add_to_peer_channel_send_queue();
+
+    return true;
+}
+
+bool lnl::net_notified_channel::deliver(lnl::net_packet* packet) {
+    m_peer->m_net_manager->create_receive_event(packet,
+                                                DELIVERY_METHOD::UNRELIABLE_NOTIFIED,
+                                                m_peer->get_channel_number(m_id),
+                                                net_constants::CHANNELED_HEADER_SIZE,
+                                                m_peer->m_endpoint);
+    return true;
+}
+
+void lnl::net_notified_channel::on_delivered(void* userData) {
+    m_peer->m_net_manager->message_delivered(m_peer->m_endpoint, userData);
+}
+
+void lnl::net_notified_channel::on_lost(void* userData) {
+    m_peer->m_net_manager->message_lost(m_peer->m_endpoint, userData);
+}
+
+void lnl::net_notified_channel::process_ack(lnl::net_packet* packet) {
+    if (packet->size() != m_outgoing_acks.size()) {
+        return;
+    }
+
+    uint16_t ackWindowStart = packet->sequence();
+
+    net_mutex_guard guard(m_pending_mutex);
+
+    if (ackWindowStart >= net_constants::MAX_SEQUENCE ||
+        relative_sequence_number(ackWindowStart, m_local_sequence) > 0) {
+        return;
+    }
+
+    bitmap_for_each_common(&packet->data()[net_constants::CHANNELED_HEADER_SIZE],
+                           m_pending_mask.data(),
+                           m_pending_mask.size(),
+                           [&](size_t pendingIdx) {
+                               auto& pending = m_pending[pendingIdx];
+                               auto relate = relative_sequence_number(pending.sequence, ackWindowStart);
+
+                               //the same slot in the ack window refers to another sequence
+                               if (relate < 0 || relate >= m_window_size) {
+                                   return;
+                               }
+
+                               bitmap_reset(m_pending_mask.data(), pendingIdx);
+                               m_pending_count--;
+                               on_delivered(pending.user_data);
+                           });
+
+    expire_pending(get_current_time(), ackWindowStart);
+}
+
+bool lnl::net_notified_channel::send_next_packets() {
+    if (m_must_send_acks) {
+        m_must_send_acks = false;
+
+        net_mutex_guard guard(m_outgoing_acks_mutex);
+        send_ack(&m_outgoing_acks);
+    }
+
+    auto currentTime = get_current_time();
+
+    net_mutex_guard guard(m_pending_mutex);
+    std::optional<net_packet*> packet;
+
+    while (has_send_quota() && (packet = m_outgoing_queue.dequeue())) {
+        auto netPacket = packet.value();
+        netPacket->set_sequence((uint16_t) m_local_sequence);
+        netPacket->set_channel_id(m_id);
+
+        if (netPacket->user_data) {
+            add_pending((uint16_t) m_local_sequence, netPacket->user_data, currentTime);
+            netPacket->user_data = nullptr;
+        }
+
+        m_local_sequence = (m_local_sequence + 1) % net_constants::MAX_SEQUENCE;
+        m_peer->send_user_data(netPacket);
+        m_peer->m_net_manager->pool_recycle(netPacket);
+    }
+
+    expire_pending(currentTime, -1);
+
+    //stays queued while deadlines are pending
+    return m_pending_count > 0 || !m_outgoing_queue.empty();
+}
+
+void lnl::net_notified_channel::add_pending(uint16_t sequence, void* userData, int64_t currentTime) {
+    expire_pending(currentTime,
+                   (sequence - m_window_size + 1 + net_constants::MAX_SEQUENCE) % net_constants::MAX_SEQUENCE);
+
+    if (m_pending_count == 0) {
+        m_local_window_start = sequence;
+    }
+
+    auto idx = sequence % m_window_size;
+    auto& pending = m_pending[idx];
+    pending.sequence = sequence;
+    //the ack may wait for the ack delay on the other side
+    pending.deadline = currentTime + (int64_t) ((m_peer->m_resend_delay + m_peer->m_net_manager->ack_delay) *
+                                               TICKS_PER_MILLISECOND);
+    pending.user_data = userData;
+
+    bitmap_set(m_pending_mask.data(), idx);
+    m_pending_count++;
+}
+
+void lnl::net_notified_channel::expire_pending(int64_t currentTime, int32_t lostBefore) {
+    while (m_pending_count > 0) {
+        auto distance = bitmap_distance_to_next_set(m_pending_mask.data(), m_window_size,
+                                                    m_local_window_start % m_window_size);
+        auto seq = (int32_t) ((m_local_window_start + distance) % net_constants::MAX_SEQUENCE);
+        auto idx = seq % m_window_size;
+
+        if (m_pending[idx].deadline > currentTime &&
+            (lostBefore < 0 || relative_sequence_number(seq, lostBefore) >= 0)) {
+            m_local_window_start = seq;
+            return;
+        }
+
+        report_lost(idx);
+        m_local_window_start = (seq + 1) % net_constants::MAX_SEQUENCE;
+    }
+
+    m_local_window_start = m_local_sequence;
+}
+
+void lnl::net_notified_channel::report_lost(size_t idx) {
+    bitmap_reset(m_pending_mask.data(), idx);
+    m_pending_count--;
+    on_lost(m_pending[idx].user_data);
+}
+
+size_t lnl::net_notified_channel::ack_size() const {
+    return m_outgoing_acks.size() - net_constants::HEADER_SIZE;
+}
+
+size_t lnl::net_notified_channel::write_ack(uint8_t* dst, size_t capacity) {
+    net_mutex_guard guard(m_outgoing_acks_mutex);
+    auto size = ack_size();
+
+    if (capacity < size) {
+        return 0;
+    }
+
+    memcpy(dst, &m_outgoing_acks.data()[net_constants::HEADER_SIZE], size);
+    return size;
+}
@@ -0,0 +1,170 @@
+#include <lnl/channels/net_redundant_channel.h>
+#include <lnl/net_peer.h>
+#include <lnl/net_manager.h>
+
+lnl::net_redundant_channel::net_redundant_channel(lnl::net_peer* peer, uint8_t id)
+        : net_base_channel(peer),
+          m_id(id),
+          m_ack_packet(std::make_unique<net_packet>(PACKET_PROPERTY::ACK, 0)) {
+    m_ack_packet->set_channel_id(id);
+}
+
+bool lnl::net_redundant_channel::process_packet(lnl::net_packet* packet) {
+    if (packet->is_fragmented()) {
+        return false;
+    }
+
+    if (packet->property() == PACKET_PROPERTY::ACK) {
+        process_ack(packet->sequence());
+        return false;
+    }
+
+    if (packet->sequence() >= net_constants::MAX_SEQUENCE) {
+        return false;
+    }
+
+    m_records.clear();
+
+    for (size_t pos = net_constants::CHANNELED_HEADER_SIZE;
+         pos + net_constants::RECORD_HEADER_SIZE <= packet->size();) {
+        auto size = packet->get_value_at<uint16_t>(pos);
+
+        if (pos + net_constants::RECORD_HEADER_SIZE + size > packet->size()) {
+            return false;
+        }
+
+        m_records.push_back(pos);
+        pos += net_constants::RECORD_HEADER_SIZE + size;
+    }
+
+    //oldest first, so messages of one packet arrive in order
+    for (auto i = (int32_t) m_records.size() - 1; i >= 0; --i) {
+        auto sequence = (packet->sequence() - i + net_constants::MAX_SEQUENCE) % net_constants::MAX_SEQUENCE;
+        auto relative = relative_sequence_number(sequence, m_remote_sequence);
+
+        if (relative > 0) {
+            m_delivered = relative < WINDOW_SIZE ? m_delivered << relative : 0;
+            m_delivered |= 1;
+            m_remote_sequence = (uint16_t) sequence;
+        } else if (-relative < WINDOW_SIZE && (m_delivered & (1ull << -relative)) == 0) {
+            m_delivered |= 1ull << -relative;
+        } else {
+            continue;
+        }
+
+        auto pos = m_records[i];
+        deliver(packet, pos + net_constants::RECORD_HEADER_SIZE, packet->get_value_at<uint16_t>(pos));
+    }
+
+    m_must_send_ack = true;
+    add_to_peer_channel_send_queue();
+
+    return false;
+}
+
+bool lnl::net_redundant_channel::send_next_packets() {
+    std::optional<net_packet*> packet;
+
+    while (has_send_quota() && (packet = m_outgoing_queue.dequeue())) {
+        auto message = packet.value();
+        m_local_sequence = (m_local_sequence + 1) % net_constants::MAX_SEQUENCE;
+        message->set_sequence((uint16_t) m_local_sequence);
+
+        net_mutex_guard guard(m_pending_mutex);
+        m_pending.push_back(message);
+        send_pending();
+    }
+
+    if (m_must_send_ack) {
+        m_must_send_ack = false;
+        m_ack_packet->set_sequence(m_remote_sequence);
+        send_ack(m_ack_packet.get());
+    }
+
+    return !m_outgoing_queue.empty();
+}
+
+void lnl::net_redundant_channel::send_pending() {
+    auto maxCount = (size_t) m_peer->m_net_manager->redundant_message_count + 1;
+    auto size = (size_t) net_constants::CHANNELED_HEADER_SIZE;
+    size_t count = 0;
+
+    for (auto it = m_pending.rbegin(); it != m_pending.rend() && count < maxCount; ++it, ++count) {
+        auto recordSize = (*it)->size() - net_constants::CHANNELED_HEADER_SIZE;
+
+        if (size + recordSize > (size_t) m_peer->m_mtu) {
+            break;
+        }
+
+        size += recordSize;
+    }
+
+    while (m_pending.size() > count) {
+        m_peer->m_net_manager->pool_recycle(m_pending.front());
+        m_pending.pop_front();
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    auto packet = m_peer->m_net_manager->pool_get_packet(size);
+    packet->set_property(PACKET_PROPERTY::CHANNELED);
+    packet->set_sequence(m_pending.back()->sequence());
+    packet->set_channel_id(m_id);
+
+    size_t pos = net_constants::CHANNELED_HEADER_SIZE;
+
+    for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it) {
+        auto recordSize = (*it)->size() - net_constants::CHANNELED_HEADER_SIZE;
+        packet->copy_from((*it)->data(), net_constants::CHANNELED_HEADER_SIZE, pos, recordSize);
+        pos += recordSize;
+    }
+
+    m_peer->send_user_data(packet);
+    m_peer->m_net_manager->pool_recycle(packet);
+}
+
+void lnl::net_redundant_channel::process_ack(uint16_t sequence) {
+    net_mutex_guard guard(m_pending_mutex);
+
+    //the acked packet carried every message still pending when it was sent
+    while (!m_pending.empty() && relative_sequence_number(m_pending.front()->sequence(), sequence) <= 0) {
+        m_peer->m_net_manager->pool_recycle(m_pending.front());
+        m_pending.pop_front();
+    }
+}
+
+void lnl::net_redundant_channel::deliver(const lnl::net_packet* packet, size_t pos, size_t size) {
+    auto message = m_peer->m_net_manager->pool_get_packet(net_constants::CHANNELED_HEADER_SIZE + size);
+    message->set_property(PACKET_PROPERTY::CHANNELED);
+    message->copy_from(packet->data(), pos, net_constants::CHANNELED_HEADER_SIZE, size);
+
+    m_peer->m_net_manager->create_receive_event(message,
+                                                DELIVERY_METHOD::REDUNDANT,
+                                                m_peer->get_channel_number(m_id),
+                                                net_constants::CHANNELED_HEADER_SIZE,
+                                                m_peer->m_endpoint);
+}
+
+size_t lnl::net_redundant_channel::ack_size() const {
+    return m_ack_packet->size() - net_constants::HEADER_SIZE;
+}
+
+size_t lnl::net_redundant_channel::write_ack(uint8_t* dst, size_t capacity) {
+    auto size = ack_size();
+
+    if (capacity < size) {
+        return 0;
+    }
+
+    m_ack_packet->set_sequence(m_remote_sequence);
+    memcpy(dst, &m_ack_packet->data()[net_constants::HEADER_SIZE], size);
+    return size;
+}
+
+lnl::net_redundant_channel::~net_redundant_channel() {
+    for (auto packet: m_pending) {
+        m_peer->m_net_manager->pool_recycle(packet);
+    }
+}
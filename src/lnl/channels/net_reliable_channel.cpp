@@ -1,5 +1,6 @@
 #include <lnl/channels/net_reliable_channel.h>
 #include <lnl/net_peer.h>
+#include <lnl/net_manager.h>
 #include <lnl/net_utils.h>
 
 bool lnl::net_reliable_channel::process_packet(lnl::net_packet* packet) {
@@ -41,13 +42,11 @@ bool lnl::net_reliable_channel::process_packet(lnl::net_packet* packet) {
             m_outgoing_acks.set_sequence(newWindowStart);
 
             //Clean old data
-            while (m_remote_window_start != newWindowStart) {
-                ackIdx = m_remote_window_start % m_window_size;
-                ackByte = net_constants::CHANNELED_HEADER_SIZE + ackIdx / BITS_IN_BYTE;
-                ackBit = ackIdx % BITS_IN_BYTE;
-                m_outgoing_acks.data()[ackByte] &= (uint8_t) ~(1 << ackBit);
-                m_remote_window_start = (m_remote_window_start + 1) % net_constants::MAX_SEQUENCE;
-            }
+            bitmap_clear_circular(&m_outgoing_acks.data()[net_constants::CHANNELED_HEADER_SIZE],
+                                  m_window_size,
+                                  m_remote_window_start % m_window_size,
+                                  relative_sequence_number(newWindowStart, m_remote_window_start));
+            m_remote_window_start = newWindowStart;
         }
 
         //Final stage - process valid packet
@@ -120,29 +119,86 @@ void lnl::net_reliable_channel::process_ack(lnl::net_packet* packet) {
 
     net_mutex_guard guard(m_pending_packets_mutex);
 
-    for (auto pendingSeq = m_local_window_start;
-         pendingSeq != m_local_sequence;
-         pendingSeq = (pendingSeq + 1) % net_constants::MAX_SEQUENCE) {
-        auto rel = relative_sequence_number(pendingSeq, ackWindowStart);
+    auto currentTime = get_current_time();
+    auto windowStartIdx = m_local_window_start % m_window_size;
+    auto inFlight = relative_sequence_number(m_local_sequence, m_local_window_start);
+    auto newestAckedRelate = -1;
+    int64_t newestAckedTime = 0;
+
+    //only slots that are both pending and acked are visited
+    bitmap_for_each_common(&packet->data()[net_constants::CHANNELED_HEADER_SIZE],
+                           m_pending_mask.data(),
+                           m_pending_mask.size(),
+                           [&](size_t pendingIdx) {
+                               auto pendingSeq = (m_local_window_start +
+                                                  (int32_t) (pendingIdx + m_window_size - windowStartIdx) %
+                                                  m_window_size) % net_constants::MAX_SEQUENCE;
+
+                               //the same slot in the ack window refers to an older sequence
+                               if (relative_sequence_number(pendingSeq, ackWindowStart) >= m_window_size) {
+                                   return;
+                               }
+
+                               auto& pendingPacket = m_pending_packets[pendingIdx];
+                               auto pendingRelate = relative_sequence_number(pendingSeq, m_local_window_start);
+
+                               if (pendingRelate > newestAckedRelate) {
+                                   newestAckedRelate = pendingRelate;
+                                   newestAckedTime = pendingPacket.sent_time();
+                               }
+
+                               bitmap_reset(m_pending_mask.data(), pendingIdx);
+                               pendingPacket.clear(currentTime, m_peer);
+                           });
+
+    if (newestAckedRelate >= FAST_RETRANSMIT_THRESHOLD &&
+        fast_retransmit(newestAckedRelate, newestAckedTime, currentTime)) {
+        add_to_peer_channel_send_queue();
+    }
 
-        if (rel >= m_window_size) {
-            break;
-        }
+    auto acked = (int32_t) bitmap_distance_to_next_set(m_pending_mask.data(), m_window_size, windowStartIdx);
+    m_local_window_start = (m_local_window_start + std::min(acked, inFlight)) % net_constants::MAX_SEQUENCE;
+}
 
-        auto pendingIdx = pendingSeq % m_window_size;
-        auto currentByte = net_constants::CHANNELED_HEADER_SIZE + pendingIdx / BITS_IN_BYTE;
-        auto currentBit = pendingIdx % BITS_IN_BYTE;
+size_t lnl::net_reliable_channel::ack_size() const {
+    return m_outgoing_acks.size() - net_constants::HEADER_SIZE;
+}
 
-        if ((packet->data()[currentByte] & (1 << currentBit)) == 0) {
-            continue;
-        }
+size_t lnl::net_reliable_channel::write_ack(uint8_t* dst, size_t capacity) {
+    net_mutex_guard guard(m_outgoing_acks_mutex);
+    auto size = ack_size();
+
+    if (capacity < size) {
+        return 0;
+    }
 
-        if (pendingSeq == m_local_window_start) {
-            m_local_window_start = (m_local_window_start + 1) % net_constants::MAX_SEQUENCE;
+    memcpy(dst, &m_outgoing_acks.data()[net_constants::HEADER_SIZE], size);
+    return size;
+}
+
+bool lnl::net_reliable_channel::fast_retransmit(int32_t newestAckedRelate, int64_t newestAckedTime,
+                                                int64_t currentTime) {
+    auto windowStartIdx = m_local_window_start % m_window_size;
+    auto expired = false;
+
+    //walk the still pending slots from the window start
+    for (auto relate = (int32_t) bitmap_distance_to_next_set(m_pending_mask.data(), m_window_size, windowStartIdx);
+         relate <= newestAckedRelate - FAST_RETRANSMIT_THRESHOLD;
+         relate += 1 + (int32_t) bitmap_distance_to_next_set(m_pending_mask.data(), m_window_size,
+                                                             (windowStartIdx + relate + 1) % m_window_size)) {
+        auto seq = (m_local_window_start + relate) % net_constants::MAX_SEQUENCE;
+        auto& pendingPacket = m_pending_packets[seq % m_window_size];
+
+        //resent after the newest acked packet went out, its copy may still be on the way
+        if (pendingPacket.sent_time() > newestAckedTime || !pendingPacket.expire(currentTime)) {
+            continue;
         }
 
-        m_pending_packets[pendingIdx].clear(m_peer);
+        m_resend_queue.push({currentTime, (uint16_t) seq});
+        expired = true;
     }
+
+    return expired;
 }
 
 bool lnl::net_reliable_channel::send_next_packets() {
@@ -150,13 +206,39 @@ bool lnl::net_reliable_channel::send_next_packets() {
         m_must_send_acks = false;
 
         net_mutex_guard guard(m_outgoing_acks_mutex);
-        m_peer->send_user_data(&m_outgoing_acks);
+        send_ack(&m_outgoing_acks);
     }
 
     auto currentTime = get_current_time();
-    auto hasPendingPackets = false;
 
     net_mutex_guard guard(m_pending_packets_mutex);
+
+    //resends go first, only the packets that are due are touched
+    while (!m_resend_queue.empty()) {
+        auto entry = m_resend_queue.top();
+        auto& pendingPacket = m_pending_packets[entry.sequence % m_window_size];
+
+        if (!pendingPacket.is_due(entry.deadline, entry.sequence)) {
+            //already acked
+            m_resend_queue.pop();
+            continue;
+        }
+
+        if (entry.deadline > currentTime) {
+            break;
+        }
+
+        pendingPacket.mark_lost(currentTime, m_peer);
+
+        if (!m_peer->congestion_can_send(pendingPacket.size())) {
+            //stays due until the congestion window opens
+            break;
+        }
+
+        m_resend_queue.pop();
+        m_resend_queue.push({pendingPacket.send(currentTime, m_peer), entry.sequence});
+    }
+
     while (!m_outgoing_queue.empty()) {
         auto relate = relative_sequence_number(m_local_sequence, m_local_window_start);
 
@@ -164,58 +246,107 @@ bool lnl::net_reliable_channel::send_next_packets() {
             break;
         }
 
+        auto nextPacket = m_outgoing_queue.peek();
+
+        if (!nextPacket ||
+            !has_send_quota() ||
+            !m_peer->congestion_can_send(nextPacket.value()->size())) {
+            break;
+        }
+
         auto netPacket = m_outgoing_queue.dequeue();
 
         if (!netPacket) {
             break;
         }
 
+        if (m_peer->m_extensions.has(PROTOCOL_FEATURE::RELIABLE_BUNDLE)) {
+            bundle(*netPacket);
+        }
+
         netPacket.value()->set_sequence(m_local_sequence);
         netPacket.value()->set_channel_id(m_id);
-        m_pending_packets[m_local_sequence % m_window_size].init(*netPacket);
+
+        auto& pendingPacket = m_pending_packets[m_local_sequence % m_window_size];
+        pendingPacket.init(*netPacket);
+        bitmap_set(m_pending_mask.data(), m_local_sequence % m_window_size);
+        m_resend_queue.push({pendingPacket.send(currentTime, m_peer), (uint16_t) m_local_sequence});
+
         m_local_sequence = (m_local_sequence + 1) % net_constants::MAX_SEQUENCE;
     }
 
-    for (int32_t pendingSeq = m_local_window_start;
-         pendingSeq != m_local_sequence;
-         pendingSeq = (pendingSeq + 1) % net_constants::MAX_SEQUENCE) {
-        if (!m_pending_packets[pendingSeq % m_window_size].try_send(currentTime, m_peer)) {
-            continue;
-        }
-
-        hasPendingPackets = true;
+    //the next resend doesn't wait for the next update, an acked entry only costs a spurious wakeup
+    if (!m_resend_queue.empty() && m_resend_queue.top().deadline > currentTime) {
+        m_peer->schedule_wakeup(m_resend_queue.top().deadline - currentTime);
     }
 
-    return hasPendingPackets || m_must_send_acks || !m_outgoing_queue.empty();
+    return !m_resend_queue.empty() || m_must_send_acks || !m_outgoing_queue.empty();
 }
 
-bool lnl::net_reliable_channel::pending_packet::try_send(int64_t currentTime, net_peer* peer) {
-    if (m_packet == nullptr) {
-        return false;
+void lnl::net_reliable_channel::bundle(lnl::net_packet* packet) {
+    //delivery events are reported per sequence
+    if (packet->is_fragmented() || packet->user_data) {
+        return;
     }
 
-    if (m_is_sent) {
-        auto resendDelay = peer->m_resend_delay * TICKS_PER_MILLISECOND;
-        auto packetHoldTime = (double) (currentTime - m_timestamp);
+    std::optional<net_packet*> next;
 
-        if (packetHoldTime < resendDelay) {
-            return false;
+    while ((next = m_outgoing_queue.peek())) {
+        auto nextPacket = next.value();
+        auto recordSize = nextPacket->size() - net_constants::CHANNELED_HEADER_SIZE;
+
+        if (nextPacket->is_fragmented() || nextPacket->user_data || packet->size() + recordSize > (size_t) m_peer->m_mtu) {
+            break;
         }
+
+        m_outgoing_queue.dequeue();
+
+        auto pos = packet->size();
+        packet->resize(pos + recordSize);
+        packet->copy_from(nextPacket->data(), net_constants::CHANNELED_HEADER_SIZE, pos, recordSize);
+        m_peer->m_net_manager->pool_recycle(nextPacket);
     }
+}
+
+int64_t lnl::net_reliable_channel::pending_packet::send(int64_t currentTime, net_peer* peer) {
+    auto backoff = 1 << std::min(m_resend_count, MAX_RESEND_BACKOFF);
 
     m_timestamp = currentTime;
-    m_is_sent = true;
+    m_deadline = currentTime + (int64_t) (peer->m_resend_delay * TICKS_PER_MILLISECOND) * backoff;
+    m_resend_count++;
+    m_in_flight = true;
 
+    peer->congestion_on_sent(m_packet->size(), currentTime);
     peer->send_user_data(m_packet);
 
-    return true;
+    return m_deadline;
 }
 
-bool lnl::net_reliable_channel::pending_packet::clear(lnl::net_peer* peer) {
+void lnl::net_reliable_channel::pending_packet::mark_lost(int64_t currentTime, lnl::net_peer* peer) {
+    if (!m_in_flight) {
+        return;
+    }
+
+    m_in_flight = false;
+    peer->congestion_on_lost(m_packet->size(), m_timestamp, currentTime);
+}
+
+bool lnl::net_reliable_channel::pending_packet::clear(int64_t currentTime, lnl::net_peer* peer) {
     if (m_packet == nullptr) {
         return false;
     }
 
+    if (m_in_flight) {
+        //resent packets give ambiguous rtt samples
+        auto rtt = m_resend_count == 1 ? currentTime - m_timestamp : 0;
+        peer->congestion_on_acked(m_packet->size(), rtt, currentTime);
+
+        if (rtt > 0) {
+            peer->update_roundtrip_time((double) rtt / TICKS_PER_MILLISECOND);
+        }
+        m_in_flight = false;
+    }
+
     peer->recycle_and_deliver(m_packet);
     m_packet = nullptr;
 
@@ -53,7 +53,7 @@ bool lnl::net_sequenced_channel::send_next_packets() {
         }
     } else {
         std::optional<net_packet*> packet;
-        while ((packet = m_outgoing_queue.dequeue())) {
+        while (has_send_quota() && (packet = m_outgoing_queue.dequeue())) {
             m_local_sequence = (m_local_sequence + 1) % net_constants::MAX_SEQUENCE;
             packet.value()->set_sequence((uint16_t) m_local_sequence);
             packet.value()->set_channel_id(m_id);
@@ -71,10 +71,26 @@ bool lnl::net_sequenced_channel::send_next_packets() {
     if (m_reliable && m_must_send_ack) {
         m_must_send_ack = false;
         m_ack_packet->set_sequence(m_remote_sequence);
-        m_peer->send_user_data(m_ack_packet.get());
+        send_ack(m_ack_packet.get());
     }
 
-    return m_last_packet != nullptr;
+    return m_last_packet != nullptr || !m_outgoing_queue.empty();
+}
+
+size_t lnl::net_sequenced_channel::ack_size() const {
+    return m_ack_packet ? m_ack_packet->size() - net_constants::HEADER_SIZE : 0;
+}
+
+size_t lnl::net_sequenced_channel::write_ack(uint8_t* dst, size_t capacity) {
+    auto size = ack_size();
+
+    if (size == 0 || capacity < size) {
+        return 0;
+    }
+
+    m_ack_packet->set_sequence(m_remote_sequence);
+    memcpy(dst, &m_ack_packet->data()[net_constants::HEADER_SIZE], size);
+    return size;
 }
 
 lnl::net_sequenced_channel::~net_sequenced_channel() {
@@ -0,0 +1,27 @@
+#include <lnl/congestion/net_aimd_congestion_controller.h>
+
+#include <algorithm>
+
+void lnl::net_aimd_congestion_controller::on_acked(size_t bytes, int64_t rtt, int64_t currentTime) {
+    if (rtt > 0 && (m_min_rtt == 0 || rtt < m_min_rtt)) {
+        m_min_rtt = rtt;
+    }
+
+    if (m_window < m_slow_start_threshold) {
+        m_window += bytes;
+        return;
+    }
+
+    m_window += std::max<size_t>(1, m_segment_size * bytes / m_window);
+}
+
+void lnl::net_aimd_congestion_controller::on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) {
+    if (sentTime < m_recovery_start) {
+        return;
+    }
+
+    m_recovery_start = currentTime;
+    m_loss_events++;
+    m_slow_start_threshold = std::max(m_window / 2, m_segment_size * MIN_WINDOW_SEGMENTS);
+    m_window = m_slow_start_threshold;
+}
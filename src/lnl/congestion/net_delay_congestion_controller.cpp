@@ -0,0 +1,89 @@
+#include <lnl/congestion/net_delay_congestion_controller.h>
+
+#include <algorithm>
+
+size_t lnl::net_delay_congestion_controller::congestion_window() const {
+    if (m_bottleneck_bandwidth <= 0. || m_min_rtt == 0) {
+        return m_segment_size * INITIAL_WINDOW_SEGMENTS;
+    }
+
+    auto gain = m_mode == MODE::STARTUP ? STARTUP_GAIN : CWND_GAIN;
+
+    return std::max((size_t) (gain * bandwidth_delay_product()), m_segment_size * MIN_WINDOW_SEGMENTS);
+}
+
+double lnl::net_delay_congestion_controller::pacing_rate() const {
+    switch (m_mode) {
+        case MODE::STARTUP:
+            return m_bottleneck_bandwidth * STARTUP_GAIN;
+        case MODE::DRAIN:
+            return m_bottleneck_bandwidth / STARTUP_GAIN;
+        case MODE::PROBE_BANDWIDTH:
+            return m_bottleneck_bandwidth * PROBE_GAINS[m_probe_phase];
+    }
+
+    return 0.;
+}
+
+void lnl::net_delay_congestion_controller::on_acked(size_t bytes, int64_t rtt, int64_t currentTime) {
+    if (rtt > 0 && (m_min_rtt == 0 || rtt <= m_min_rtt || currentTime - m_min_rtt_stamp > MIN_RTT_EXPIRATION)) {
+        m_min_rtt = rtt;
+        m_min_rtt_stamp = currentTime;
+    }
+
+    if (m_round_start == 0) {
+        m_round_start = currentTime;
+    }
+
+    m_round_acked += bytes;
+
+    if (currentTime - m_round_start >= std::max(m_min_rtt, MIN_ROUND_TIME)) {
+        finish_round(currentTime);
+    }
+
+    if (m_mode == MODE::DRAIN && (double) m_bytes_in_flight <= bandwidth_delay_product()) {
+        m_mode = MODE::PROBE_BANDWIDTH;
+        m_probe_phase = 0;
+    }
+}
+
+void lnl::net_delay_congestion_controller::finish_round(int64_t currentTime) {
+    auto sample = (double) m_round_acked * TICKS_PER_SECOND / (double) (currentTime - m_round_start);
+
+    m_bandwidth_samples[m_round % BANDWIDTH_FILTER_LENGTH] = sample;
+    m_bottleneck_bandwidth = *std::max_element(m_bandwidth_samples.begin(), m_bandwidth_samples.end());
+
+    m_round++;
+    m_round_start = currentTime;
+    m_round_acked = 0;
+
+    switch (m_mode) {
+        case MODE::STARTUP: {
+            //the pipe is full once bandwidth stops growing by 25% per round
+            if (m_bottleneck_bandwidth >= m_full_bandwidth * 1.25) {
+                m_full_bandwidth = m_bottleneck_bandwidth;
+                m_full_bandwidth_rounds = 0;
+            } else if (++m_full_bandwidth_rounds >= STARTUP_FULL_ROUNDS) {
+                m_mode = MODE::DRAIN;
+            }
+            break;
+        }
+
+        case MODE::PROBE_BANDWIDTH: {
+            m_probe_phase = (m_probe_phase + 1) % PROBE_GAINS.size();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void lnl::net_delay_congestion_controller::on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) {
+    m_loss_events++;
+
+    //losses while probing mean the queue overflowed before the delay signal showed it
+    if (m_mode == MODE::STARTUP) {
+        m_mode = MODE::DRAIN;
+    }
+}
@@ -0,0 +1,463 @@
+#include <lnl/net_chacha20_poly1305.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CHACHA20_SSE2
+
+#include <emmintrin.h>
+
+#endif
+
+namespace {
+    constexpr uint32_t SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574}; //"expand 32-byte k"
+    constexpr size_t BLOCK_SIZE = 64;
+    //lanes collected before the keystream is generated, a multiple of the vector width
+    constexpr size_t LANE_BATCH_SIZE = 16;
+    //jobs whose poly1305 keys are kept at once
+    constexpr size_t JOB_BATCH_SIZE = 16;
+
+    uint32_t load32(const uint8_t* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    void store32(uint8_t* data, uint32_t value) {
+        memcpy(data, &value, sizeof(value));
+    }
+
+    uint32_t rotl(uint32_t value, int count) {
+        return value << count | value >> (32 - count);
+    }
+
+    void quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+        a += b;
+        d = rotl(d ^ a, 16);
+        c += d;
+        b = rotl(b ^ c, 12);
+        a += b;
+        d = rotl(d ^ a, 8);
+        c += d;
+        b = rotl(b ^ c, 7);
+    }
+
+#ifdef CHACHA20_SSE2
+
+    template <int COUNT>
+    __m128i rotl(__m128i value) {
+        return _mm_or_si128(_mm_slli_epi32(value, COUNT), _mm_srli_epi32(value, 32 - COUNT));
+    }
+
+    void quarter_round(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+        a = _mm_add_epi32(a, b);
+        d = rotl<16>(_mm_xor_si128(d, a));
+        c = _mm_add_epi32(c, d);
+        b = rotl<12>(_mm_xor_si128(b, c));
+        a = _mm_add_epi32(a, b);
+        d = rotl<8>(_mm_xor_si128(d, a));
+        c = _mm_add_epi32(c, d);
+        b = rotl<7>(_mm_xor_si128(b, c));
+    }
+
+#endif
+
+    template <typename T>
+    void double_rounds(T* x) {
+        for (int i = 0; i < 10; ++i) {
+            quarter_round(x[0], x[4], x[8], x[12]);
+            quarter_round(x[1], x[5], x[9], x[13]);
+            quarter_round(x[2], x[6], x[10], x[14]);
+            quarter_round(x[3], x[7], x[11], x[15]);
+            quarter_round(x[0], x[5], x[10], x[15]);
+            quarter_round(x[1], x[6], x[11], x[12]);
+            quarter_round(x[2], x[7], x[8], x[13]);
+            quarter_round(x[3], x[4], x[9], x[14]);
+        }
+    }
+
+    //one keystream block and where it goes
+    struct lane {
+        const uint32_t* key;
+        uint32_t counter;
+        uint32_t nonce[3];
+        //nullptr stores the keystream itself
+        const uint8_t* src;
+        uint8_t* dst;
+        size_t size;
+
+        void init_state(uint32_t* state) const {
+            memcpy(state, SIGMA, sizeof(SIGMA));
+            memcpy(&state[4], key, 8 * sizeof(uint32_t));
+            state[12] = counter;
+            memcpy(&state[13], nonce, sizeof(nonce));
+        }
+
+        //src may be dst, every word is read before it is written
+        void apply(const uint8_t* keystream) const {
+            if (!src) {
+                memcpy(dst, keystream, size);
+                return;
+            }
+
+            size_t pos = 0;
+
+            for (; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+                uint64_t word;
+                uint64_t stream;
+                memcpy(&word, &src[pos], sizeof(word));
+                memcpy(&stream, &keystream[pos], sizeof(stream));
+                word ^= stream;
+                memcpy(&dst[pos], &word, sizeof(word));
+            }
+
+            for (; pos < size; ++pos) {
+                dst[pos] = src[pos] ^ keystream[pos];
+            }
+        }
+    };
+
+    void chacha20_block(const lane& lane) {
+        uint32_t state[16];
+        uint32_t x[16];
+        uint8_t keystream[BLOCK_SIZE];
+
+        lane.init_state(state);
+        memcpy(x, state, sizeof(x));
+        double_rounds(x);
+
+        for (int i = 0; i < 16; ++i) {
+            store32(&keystream[i * 4], x[i] + state[i]);
+        }
+
+        lane.apply(keystream);
+    }
+
+#ifdef CHACHA20_SSE2
+
+    //vector element i of x[k] is word k of lane i, each lane may have its own key, nonce and counter
+    void chacha20_blocks_4(const lane* lanes) {
+        uint32_t words[4][16];
+        __m128i state[16];
+        __m128i x[16];
+        alignas(16) uint8_t keystream[4][BLOCK_SIZE];
+
+        for (int i = 0; i < 4; ++i) {
+            lanes[i].init_state(words[i]);
+        }
+
+        for (int k = 0; k < 16; ++k) {
+            state[k] = _mm_set_epi32((int) words[3][k], (int) words[2][k], (int) words[1][k], (int) words[0][k]);
+            x[k] = state[k];
+        }
+
+        double_rounds(x);
+
+        //transposes each group of four words back into the blocks
+        for (int k = 0; k < 16; k += 4) {
+            auto a0 = _mm_add_epi32(x[k], state[k]);
+            auto a1 = _mm_add_epi32(x[k + 1], state[k + 1]);
+            auto a2 = _mm_add_epi32(x[k + 2], state[k + 2]);
+            auto a3 = _mm_add_epi32(x[k + 3], state[k + 3]);
+            auto t0 = _mm_unpacklo_epi32(a0, a1);
+            auto t1 = _mm_unpacklo_epi32(a2, a3);
+            auto t2 = _mm_unpackhi_epi32(a0, a1);
+            auto t3 = _mm_unpackhi_epi32(a2, a3);
+            _mm_store_si128((__m128i*) &keystream[0][k * 4], _mm_unpacklo_epi64(t0, t1));
+            _mm_store_si128((__m128i*) &keystream[1][k * 4], _mm_unpackhi_epi64(t0, t1));
+            _mm_store_si128((__m128i*) &keystream[2][k * 4], _mm_unpacklo_epi64(t2, t3));
+            _mm_store_si128((__m128i*) &keystream[3][k * 4], _mm_unpackhi_epi64(t2, t3));
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            lanes[i].apply(keystream[i]);
+        }
+    }
+
+#endif
+
+    class lane_queue final {
+        lane m_lanes[LANE_BATCH_SIZE];
+        size_t m_count = 0;
+
+    public:
+        void push(const lane& lane) {
+            m_lanes[m_count++] = lane;
+
+            if (m_count == LANE_BATCH_SIZE) {
+                flush();
+            }
+        }
+
+        void flush() {
+            size_t i = 0;
+
+#ifdef CHACHA20_SSE2
+            for (; i + 4 <= m_count; i += 4) {
+                chacha20_blocks_4(&m_lanes[i]);
+            }
+#endif
+
+            for (; i < m_count; ++i) {
+                chacha20_block(m_lanes[i]);
+            }
+
+            m_count = 0;
+        }
+    };
+
+    //26 bit limbs, products fit into 64 bits on every platform
+    class poly1305 final {
+        static constexpr uint32_t MASK = 0x3FFFFFF;
+
+        uint32_t m_r[5];
+        uint32_t m_h[5]{};
+        uint32_t m_pad[4];
+
+    public:
+        explicit poly1305(const uint8_t* key) {
+            m_r[0] = load32(&key[0]) & 0x3FFFFFF;
+            m_r[1] = (load32(&key[3]) >> 2) & 0x3FFFF03;
+            m_r[2] = (load32(&key[6]) >> 4) & 0x3FFC0FF;
+            m_r[3] = (load32(&key[9]) >> 6) & 0x3F03FFF;
+            m_r[4] = (load32(&key[12]) >> 8) & 0x00FFFFF;
+
+            for (int i = 0; i < 4; ++i) {
+                m_pad[i] = load32(&key[16 + i * 4]);
+            }
+        }
+
+        //the aead pads every part with zeros to whole blocks
+        void update_padded(const uint8_t* data, size_t size) {
+            for (; size >= 16; data += 16, size -= 16) {
+                block(data);
+            }
+
+            if (size > 0) {
+                uint8_t last[16]{};
+                memcpy(last, data, size);
+                block(last);
+            }
+        }
+
+        void finish(uint8_t* tag) {
+            auto h0 = m_h[0];
+            auto h1 = m_h[1];
+            auto h2 = m_h[2];
+            auto h3 = m_h[3];
+            auto h4 = m_h[4];
+
+            uint32_t carry = h1 >> 26;
+            h1 &= MASK;
+            h2 += carry;
+            carry = h2 >> 26;
+            h2 &= MASK;
+            h3 += carry;
+            carry = h3 >> 26;
+            h3 &= MASK;
+            h4 += carry;
+            carry = h4 >> 26;
+            h4 &= MASK;
+            h0 += carry * 5;
+            carry = h0 >> 26;
+            h0 &= MASK;
+            h1 += carry;
+
+            //h - (2^130 - 5), kept when it doesn't go negative
+            auto g0 = h0 + 5;
+            carry = g0 >> 26;
+            g0 &= MASK;
+            auto g1 = h1 + carry;
+            carry = g1 >> 26;
+            g1 &= MASK;
+            auto g2 = h2 + carry;
+            carry = g2 >> 26;
+            g2 &= MASK;
+            auto g3 = h3 + carry;
+            carry = g3 >> 26;
+            g3 &= MASK;
+            auto g4 = h4 + carry - (1u << 26);
+
+            auto select = (g4 >> 31) - 1;
+            h0 = (h0 & ~select) | (g0 & select);
+            h1 = (h1 & ~select) | (g1 & select);
+            h2 = (h2 & ~select) | (g2 & select);
+            h3 = (h3 & ~select) | (g3 & select);
+            h4 = (h4 & ~select) | (g4 & select);
+
+            uint32_t words[4] = {
+                    h0 | h1 << 26,
+                    h1 >> 6 | h2 << 20,
+                    h2 >> 12 | h3 << 14,
+                    h3 >> 18 | h4 << 8
+            };
+
+            uint64_t sum = 0;
+
+            for (int i = 0; i < 4; ++i) {
+                sum += (uint64_t) words[i] + m_pad[i];
+                store32(&tag[i * 4], (uint32_t) sum);
+                sum >>= 32;
+            }
+        }
+
+    private:
+        void block(const uint8_t* data) {
+            auto h0 = m_h[0] + (load32(&data[0]) & MASK);
+            auto h1 = m_h[1] + ((load32(&data[3]) >> 2) & MASK);
+            auto h2 = m_h[2] + ((load32(&data[6]) >> 4) & MASK);
+            auto h3 = m_h[3] + ((load32(&data[9]) >> 6) & MASK);
+            auto h4 = m_h[4] + ((load32(&data[12]) >> 8) | (1u << 24));
+
+            uint64_t r0 = m_r[0];
+            uint64_t r1 = m_r[1];
+            uint64_t r2 = m_r[2];
+            uint64_t r3 = m_r[3];
+            uint64_t r4 = m_r[4];
+            auto s1 = r1 * 5;
+            auto s2 = r2 * 5;
+            auto s3 = r3 * 5;
+            auto s4 = r4 * 5;
+
+            auto d0 = h0 * r0 + h1 * s4 + h2 * s3 + h3 * s2 + h4 * s1;
+            auto d1 = h0 * r1 + h1 * r0 + h2 * s4 + h3 * s3 + h4 * s2;
+            auto d2 = h0 * r2 + h1 * r1 + h2 * r0 + h3 * s4 + h4 * s3;
+            auto d3 = h0 * r3 + h1 * r2 + h2 * r1 + h3 * r0 + h4 * s4;
+            auto d4 = h0 * r4 + h1 * r3 + h2 * r2 + h3 * r1 + h4 * r0;
+
+            d1 += d0 >> 26;
+            m_h[0] = (uint32_t) d0 & MASK;
+            d2 += d1 >> 26;
+            m_h[1] = (uint32_t) d1 & MASK;
+            d3 += d2 >> 26;
+            m_h[2] = (uint32_t) d2 & MASK;
+            d4 += d3 >> 26;
+            m_h[3] = (uint32_t) d3 & MASK;
+            m_h[4] = (uint32_t) d4 & MASK;
+            m_h[0] += (uint32_t) (d4 >> 26) * 5;
+            m_h[1] += m_h[0] >> 26;
+            m_h[0] &= MASK;
+        }
+    };
+
+    void compute_tag(const lnl::net_aead_job& job, const uint8_t* polyKey, uint8_t* tag) {
+        poly1305 mac(polyKey);
+        mac.update_padded(job.ad, job.ad_size);
+        mac.update_padded(job.data, job.size);
+
+        uint8_t lengths[16];
+        uint64_t adSize = job.ad_size;
+        uint64_t size = job.size;
+        memcpy(&lengths[0], &adSize, sizeof(adSize));
+        memcpy(&lengths[8], &size, sizeof(size));
+        mac.update_padded(lengths, sizeof(lengths));
+
+        mac.finish(tag);
+    }
+}
+
+lnl::net_chacha20_poly1305::net_chacha20_poly1305(const uint8_t* key, uint32_t noncePrefix)
+        : m_nonce_prefix(noncePrefix) {
+    for (size_t i = 0; i < m_key.size(); ++i) {
+        m_key[i] = load32(&key[i * 4]);
+    }
+}
+
+void lnl::net_chacha20_poly1305::derive_key(const uint8_t* key, const uint8_t* salt, uint8_t* subkey) {
+    uint32_t x[16];
+    memcpy(x, SIGMA, sizeof(SIGMA));
+
+    for (int i = 0; i < 8; ++i) {
+        x[4 + i] = load32(&key[i * 4]);
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        x[12 + i] = load32(&salt[i * 4]);
+    }
+
+    double_rounds(x);
+
+    for (int i = 0; i < 4; ++i) {
+        store32(&subkey[i * 4], x[i]);
+        store32(&subkey[16 + i * 4], x[12 + i]);
+    }
+}
+
+void lnl::net_chacha20_poly1305::seal_batch(lnl::net_aead_job* jobs, size_t count) {
+    process_batch(jobs, count, true);
+}
+
+void lnl::net_chacha20_poly1305::open_batch(lnl::net_aead_job* jobs, size_t count) {
+    process_batch(jobs, count, false);
+}
+
+void lnl::net_chacha20_poly1305::process_batch(lnl::net_aead_job* jobs, size_t count, bool seal) {
+    lane_queue queue;
+
+    for (size_t start = 0; start < count; start += JOB_BATCH_SIZE) {
+        auto end = std::min(count, start + JOB_BATCH_SIZE);
+        uint8_t polyKeys[JOB_BATCH_SIZE][32];
+
+        auto make_lane = [](const net_aead_job& job, uint32_t counter) {
+            lane result{};
+            result.key = job.cipher->m_key.data();
+            result.counter = counter;
+            result.nonce[0] = job.cipher->m_nonce_prefix;
+            result.nonce[1] = (uint32_t) job.nonce;
+            result.nonce[2] = (uint32_t) (job.nonce >> 32);
+            return result;
+        };
+
+        //block 0 of every nonce keys its poly1305
+        for (auto i = start; i < end; ++i) {
+            auto keyLane = make_lane(jobs[i], 0);
+            keyLane.dst = polyKeys[i - start];
+            keyLane.size = sizeof(polyKeys[0]);
+            queue.push(keyLane);
+        }
+
+        queue.flush();
+
+        //the tag covers the ciphertext, so open checks it before decrypting
+        if (!seal) {
+            for (auto i = start; i < end; ++i) {
+                uint8_t tag[TAG_SIZE];
+                compute_tag(jobs[i], polyKeys[i - start], tag);
+
+                uint8_t difference = 0;
+
+                for (size_t pos = 0; pos < TAG_SIZE; ++pos) {
+                    difference |= tag[pos] ^ jobs[i].tag[pos];
+                }
+
+                jobs[i].valid = difference == 0;
+            }
+        }
+
+        for (auto i = start; i < end; ++i) {
+            auto& job = jobs[i];
+
+            if (!seal && !job.valid) {
+                continue;
+            }
+
+            for (size_t pos = 0; pos < job.size; pos += BLOCK_SIZE) {
+                auto dataLane = make_lane(job, (uint32_t) (pos / BLOCK_SIZE + 1));
+                dataLane.src = &job.data[pos];
+                dataLane.dst = &job.data[pos];
+                dataLane.size = std::min(BLOCK_SIZE, job.size - pos);
+                queue.push(dataLane);
+            }
+        }
+
+        queue.flush();
+
+        if (seal) {
+            for (auto i = start; i < end; ++i) {
+                compute_tag(jobs[i], polyKeys[i - start], jobs[i].tag);
+                jobs[i].valid = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,219 @@
+#include <lnl/net_compact_header.h>
+#include <lnl/net_utils.h>
+#include <lnl/net_varint.h>
+
+namespace {
+    constexpr size_t MAX_HEADER_SIZE = 16;
+
+    bool has_channeled_header(uint8_t property) {
+        switch ((lnl::PACKET_PROPERTY) (property & 0x1F)) {
+            case lnl::PACKET_PROPERTY::CHANNELED:
+            case lnl::PACKET_PROPERTY::ACK:
+            case lnl::PACKET_PROPERTY::CHANNELED_ACK:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    size_t zigzag(int32_t value) {
+        return (size_t) (((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+    }
+
+    int32_t unzigzag(size_t value) {
+        return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+    }
+}
+
+size_t lnl::net_compact_writer::write(const lnl::net_packet* merged, size_t size, lnl::net_packet* dst,
+                                      size_t capacity) {
+    auto src = merged->data();
+    auto out = dst->data();
+    size_t srcPos = net_constants::HEADER_SIZE;
+    size_t pos = net_constants::HEADER_SIZE;
+
+    int32_t lastChannelId = -1;
+    uint16_t lastSequence = 0;
+
+    while (srcPos + 2 <= size) {
+        size_t recordSize = merged->get_value_at<uint16_t>(srcPos);
+        auto record = &src[srcPos + 2];
+        srcPos += 2 + recordSize;
+
+        if (recordSize == 0 || srcPos > size) {
+            return 0;
+        }
+
+        uint8_t header[MAX_HEADER_SIZE];
+        size_t headerSize = 1;
+        size_t fullHeaderSize = net_constants::HEADER_SIZE;
+        auto property = (uint8_t) (record[0] & 0x9F);
+
+        if (has_channeled_header(property)) {
+            auto sequence = *(const uint16_t*) &record[1];
+            auto channelId = record[3];
+
+            if (recordSize < net_constants::CHANNELED_HEADER_SIZE || sequence >= net_constants::MAX_SEQUENCE) {
+                return 0;
+            }
+
+            if (channelId == lastChannelId) {
+                property |= SAME_CHANNEL;
+            } else {
+                header[headerSize++] = channelId;
+            }
+
+            if (lastChannelId < 0) {
+                memcpy(&header[headerSize], &sequence, sizeof(sequence));
+                headerSize += sizeof(sequence);
+            } else if (sequence == (lastSequence + 1) % net_constants::MAX_SEQUENCE) {
+                property |= NEXT_SEQUENCE;
+            } else {
+                write_varint(header, MAX_HEADER_SIZE, headerSize,
+                             zigzag(relative_sequence_number(sequence, lastSequence)));
+            }
+
+            fullHeaderSize = net_constants::CHANNELED_HEADER_SIZE;
+
+            if ((property & 0x80) != 0) {
+                if (recordSize < net_constants::FRAGMENTED_HEADER_TOTAL_SIZE) {
+                    return 0;
+                }
+
+                memcpy(&header[headerSize], &record[4], sizeof(uint16_t));
+                headerSize += sizeof(uint16_t);
+                write_varint(header, MAX_HEADER_SIZE, headerSize, *(const uint16_t*) &record[6]);
+                write_varint(header, MAX_HEADER_SIZE, headerSize, *(const uint16_t*) &record[8]);
+                fullHeaderSize = net_constants::FRAGMENTED_HEADER_TOTAL_SIZE;
+            }
+
+            lastChannelId = channelId;
+            lastSequence = sequence;
+        }
+
+        header[0] = property;
+
+        auto dataSize = recordSize - fullHeaderSize;
+        auto compactSize = headerSize + dataSize;
+
+        if (pos + varint_size(compactSize) + compactSize > capacity) {
+            return 0;
+        }
+
+        write_varint(out, capacity, pos, compactSize);
+        memcpy(&out[pos], header, headerSize);
+        memcpy(&out[pos + headerSize], &record[fullHeaderSize], dataSize);
+        pos += compactSize;
+    }
+
+    return pos;
+}
+
+bool lnl::net_compact_reader::read_next(lnl::net_packet* dst) {
+    auto src = m_packet->data();
+    auto size = m_packet->size();
+    size_t recordSize;
+
+    if (!read_varint(src, size, m_pos, recordSize) || recordSize == 0 || size - m_pos < recordSize) {
+        return false;
+    }
+
+    auto end = m_pos + recordSize;
+    auto pos = m_pos;
+    m_pos = end;
+
+    auto property = src[pos++];
+    auto flags = (uint8_t) (property & (net_compact_writer::SAME_CHANNEL | net_compact_writer::NEXT_SEQUENCE));
+    property = (uint8_t) ((property & 0x9F) | (m_packet->connection_number() << 5));
+
+    if ((property & 0x1F) >= (uint8_t) PACKET_PROPERTY::COUNT) {
+        return false;
+    }
+
+    if (!has_channeled_header(property)) {
+        if (flags != 0) {
+            return false;
+        }
+
+        dst->resize(end - pos + net_constants::HEADER_SIZE);
+        dst->data()[0] = property;
+        dst->copy_from(src, pos, net_constants::HEADER_SIZE, end - pos);
+        return true;
+    }
+
+    int32_t channelId;
+
+    if ((flags & net_compact_writer::SAME_CHANNEL) != 0) {
+        channelId = m_channel_id;
+    } else if (pos < end) {
+        channelId = src[pos++];
+    } else {
+        return false;
+    }
+
+    uint16_t sequence;
+
+    if ((flags & net_compact_writer::NEXT_SEQUENCE) != 0) {
+        sequence = (uint16_t) ((m_sequence + 1) % net_constants::MAX_SEQUENCE);
+    } else if (m_channel_id < 0) {
+        if (end - pos < sizeof(sequence)) {
+            return false;
+        }
+
+        memcpy(&sequence, &src[pos], sizeof(sequence));
+        pos += sizeof(sequence);
+    } else {
+        size_t delta;
+
+        if (!read_varint(src, end, pos, delta) || delta >= net_constants::MAX_SEQUENCE) {
+            return false;
+        }
+
+        sequence = (uint16_t) ((m_sequence + unzigzag(delta) + net_constants::MAX_SEQUENCE) %
+                               net_constants::MAX_SEQUENCE);
+    }
+
+    //the first channeled record has neither a channel nor a sequence to refer to
+    if (channelId < 0 || (m_channel_id < 0 && flags != 0)) {
+        return false;
+    }
+
+    size_t headerSize = net_constants::CHANNELED_HEADER_SIZE;
+    uint16_t fragmentId = 0;
+    size_t fragmentPart = 0;
+    size_t totalFragments = 0;
+
+    if ((property & 0x80) != 0) {
+        if (end - pos < sizeof(fragmentId)) {
+            return false;
+        }
+
+        memcpy(&fragmentId, &src[pos], sizeof(fragmentId));
+        pos += sizeof(fragmentId);
+
+        if (!read_varint(src, end, pos, fragmentPart) || !read_varint(src, end, pos, totalFragments) ||
+            fragmentPart > UINT16_MAX || totalFragments > UINT16_MAX) {
+            return false;
+        }
+
+        headerSize = net_constants::FRAGMENTED_HEADER_TOTAL_SIZE;
+    }
+
+    m_channel_id = channelId;
+    m_sequence = sequence;
+
+    dst->resize(headerSize + end - pos);
+    dst->data()[0] = property;
+    dst->set_sequence(sequence);
+    dst->set_channel_id((uint8_t) channelId);
+
+    if ((property & 0x80) != 0) {
+        dst->set_fragment_id(fragmentId);
+        dst->set_fragment_part((uint16_t) fragmentPart);
+        dst->set_total_fragments((uint16_t) totalFragments);
+    }
+
+    dst->copy_from(src, pos, headerSize, end - pos);
+    return true;
+}
@@ -0,0 +1,218 @@
+#include <lnl/net_compression.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    //a block ends with literals so the decoder never reads a match past its input
+    constexpr size_t LAST_LITERALS = 5;
+
+    uint32_t read32(const uint8_t* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    bool write_length(uint8_t* dst, size_t capacity, size_t& pos, size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (pos >= capacity) {
+                return false;
+            }
+
+            dst[pos++] = 255;
+        }
+
+        if (pos >= capacity) {
+            return false;
+        }
+
+        dst[pos++] = (uint8_t) length;
+        return true;
+    }
+
+    bool read_length(const uint8_t* src, size_t size, size_t& pos, size_t& length) {
+        uint8_t byte;
+
+        do {
+            if (pos >= size) {
+                return false;
+            }
+
+            byte = src[pos++];
+            length += byte;
+        } while (byte == 255);
+
+        return true;
+    }
+
+    bool write_sequence(uint8_t* dst, size_t capacity, size_t& pos,
+                        const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+        if (pos >= capacity) {
+            return false;
+        }
+
+        auto matchCode = matchLength == 0 ? 0 : matchLength - lnl::net_lz_codec::MIN_MATCH;
+        auto& token = dst[pos++];
+        token = (uint8_t) (std::min<size_t>(literalCount, 15) << 4 | std::min<size_t>(matchCode, 15));
+
+        if (literalCount >= 15 && !write_length(dst, capacity, pos, literalCount - 15)) {
+            return false;
+        }
+
+        if (capacity - pos < literalCount) {
+            return false;
+        }
+
+        memcpy(&dst[pos], literals, literalCount);
+        pos += literalCount;
+
+        if (matchLength == 0) {
+            return true;
+        }
+
+        if (capacity - pos < sizeof(uint16_t)) {
+            return false;
+        }
+
+        dst[pos++] = (uint8_t) offset;
+        dst[pos++] = (uint8_t) (offset >> 8);
+
+        return matchCode < 15 || write_length(dst, capacity, pos, matchCode - 15);
+    }
+}
+
+lnl::net_lz_dictionary::net_lz_dictionary(const uint8_t* data, size_t size)
+        : m_table(1u << net_lz_codec::HASH_BITS, 0) {
+    auto start = size > net_lz_codec::MAX_OFFSET ? size - net_lz_codec::MAX_OFFSET : 0;
+    m_data.assign(&data[start], &data[size]);
+
+    for (size_t pos = 0; pos + net_lz_codec::MIN_MATCH <= m_data.size(); ++pos) {
+        m_table[net_lz_codec::hash(read32(&m_data[pos]))] = (uint32_t) pos;
+    }
+}
+
+size_t lnl::net_lz_codec::compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity,
+                                   const lnl::net_lz_dictionary* dictionary) {
+    //with a dictionary the input follows it in one window, matches may reach back into it
+    const uint8_t* window = src;
+    size_t start = 0;
+
+    if (dictionary && dictionary->size() > 0) {
+        start = dictionary->size();
+        m_window.resize(start + size);
+        memcpy(m_window.data(), dictionary->m_data.data(), start);
+        memcpy(&m_window[start], src, size);
+        window = m_window.data();
+        memcpy(m_table.data(), dictionary->m_table.data(), m_table.size() * sizeof(uint32_t));
+    } else {
+        memset(m_table.data(), 0, m_table.size() * sizeof(uint32_t));
+    }
+
+    auto end = start + size;
+    auto anchor = start;
+    auto pos = start;
+    size_t written = 0;
+
+    if (size > LAST_LITERALS + MIN_MATCH) {
+        auto matchLimit = end - LAST_LITERALS;
+
+        while (pos + MIN_MATCH <= matchLimit) {
+            auto value = read32(&window[pos]);
+            auto& slot = m_table[hash(value)];
+            auto candidate = (size_t) slot;
+            slot = (uint32_t) pos;
+
+            if (candidate >= pos || pos - candidate > MAX_OFFSET || read32(&window[candidate]) != value) {
+                //skip faster through data that doesn't compress
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            auto length = MIN_MATCH;
+
+            while (pos + length < matchLimit && window[candidate + length] == window[pos + length]) {
+                length++;
+            }
+
+            if (!write_sequence(dst, capacity, written, &window[anchor], pos - anchor, pos - candidate, length)) {
+                return 0;
+            }
+
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    if (!write_sequence(dst, capacity, written, &window[anchor], end - anchor, 0, 0)) {
+        return 0;
+    }
+
+    return written;
+}
+
+bool lnl::net_lz_codec::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t size,
+                                   const lnl::net_lz_dictionary* dictionary) {
+    auto dictionarySize = dictionary ? dictionary->size() : 0;
+    size_t srcPos = 0;
+    size_t pos = 0;
+
+    while (srcPos < srcSize) {
+        auto token = src[srcPos++];
+        size_t literalCount = token >> 4;
+
+        if (literalCount == 15 && !read_length(src, srcSize, srcPos, literalCount)) {
+            return false;
+        }
+
+        if (srcSize - srcPos < literalCount || size - pos < literalCount) {
+            return false;
+        }
+
+        memcpy(&dst[pos], &src[srcPos], literalCount);
+        srcPos += literalCount;
+        pos += literalCount;
+
+        if (srcPos == srcSize) {
+            break;
+        }
+
+        if (srcSize - srcPos < sizeof(uint16_t)) {
+            return false;
+        }
+
+        size_t offset = src[srcPos] | (size_t) src[srcPos + 1] << 8;
+        srcPos += sizeof(uint16_t);
+        size_t length = token & 0x0F;
+
+        if (length == 15 && !read_length(src, srcSize, srcPos, length)) {
+            return false;
+        }
+
+        length += MIN_MATCH;
+
+        if (offset == 0 || offset > pos + dictionarySize || size - pos < length) {
+            return false;
+        }
+
+        //the part of the match still inside the dictionary
+        if (offset > pos) {
+            auto dictionaryPos = dictionarySize - (offset - pos);
+            auto count = std::min(length, offset - pos);
+            memcpy(&dst[pos], &dictionary->m_data[dictionaryPos], count);
+            pos += count;
+            length -= count;
+        }
+
+        if (offset >= length) {
+            memcpy(&dst[pos], &dst[pos - offset], length);
+            pos += length;
+        } else {
+            //overlapping matches repeat their own output
+            for (; length > 0; --length, ++pos) {
+                dst[pos] = dst[pos - offset];
+            }
+        }
+    }
+
+    return pos == size;
+}
@@ -0,0 +1,159 @@
+#include <lnl/net_crc32c.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_HARDWARE
+
+#include <nmmintrin.h>
+
+#ifdef _MSC_VER
+
+#include <intrin.h>
+
+#define TARGET_SSE42
+#else
+//the rest of the library doesn't require SSE4.2, only these functions use it after checking the cpu
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace {
+    constexpr uint32_t POLYNOMIAL = 0x82F63B78; //reflected castagnoli
+
+    //table k maps a byte to its crc followed by k zero bytes, eight of them consume a whole word per step
+    constexpr std::array<std::array<uint32_t, 256>, 8> make_tables() {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+
+        for (uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+            }
+
+            tables[0][i] = crc;
+        }
+
+        for (size_t table = 1; table < tables.size(); ++table) {
+            for (size_t i = 0; i < 256; ++i) {
+                auto previous = tables[table - 1][i];
+                tables[table][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    constexpr auto TABLES = make_tables();
+
+    uint32_t crc32c_software(uint32_t crc, const uint8_t* data, size_t size) {
+        for (; size >= sizeof(uint64_t); data += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            word ^= crc;
+
+            crc = TABLES[7][word & 0xFF] ^
+                  TABLES[6][(word >> 8) & 0xFF] ^
+                  TABLES[5][(word >> 16) & 0xFF] ^
+                  TABLES[4][(word >> 24) & 0xFF] ^
+                  TABLES[3][(word >> 32) & 0xFF] ^
+                  TABLES[2][(word >> 40) & 0xFF] ^
+                  TABLES[1][(word >> 48) & 0xFF] ^
+                  TABLES[0][word >> 56];
+        }
+
+        for (; size > 0; ++data, --size) {
+            crc = (crc >> 8) ^ TABLES[0][(crc ^ *data) & 0xFF];
+        }
+
+        return crc;
+    }
+
+#ifdef CRC32C_HARDWARE
+
+    bool has_hardware_crc32c() {
+#ifdef _MSC_VER
+        static const bool supported = [] {
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+        }();
+#else
+        static const bool supported = __builtin_cpu_supports("sse4.2");
+#endif
+        return supported;
+    }
+
+    TARGET_SSE42 uint32_t crc32c_hardware(uint32_t crc, const uint8_t* data, size_t size) {
+        uint64_t crc64 = crc;
+
+        for (; size >= sizeof(uint64_t); data += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+
+        crc = (uint32_t) crc64;
+
+        for (; size > 0; ++data, --size) {
+            crc = _mm_crc32_u8(crc, *data);
+        }
+
+        return crc;
+    }
+
+    //three independent dependency chains, one per datagram, up to the length of the shortest
+    TARGET_SSE42 void crc32c_hardware_3(const uint8_t* const* data, const size_t* sizes, uint32_t* results) {
+        uint64_t crc0 = UINT32_MAX;
+        uint64_t crc1 = UINT32_MAX;
+        uint64_t crc2 = UINT32_MAX;
+        auto common = std::min({sizes[0], sizes[1], sizes[2]}) & ~(sizeof(uint64_t) - 1);
+
+        for (size_t pos = 0; pos < common; pos += sizeof(uint64_t)) {
+            uint64_t word0;
+            uint64_t word1;
+            uint64_t word2;
+            memcpy(&word0, &data[0][pos], sizeof(word0));
+            memcpy(&word1, &data[1][pos], sizeof(word1));
+            memcpy(&word2, &data[2][pos], sizeof(word2));
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+
+        results[0] = ~crc32c_hardware((uint32_t) crc0, &data[0][common], sizes[0] - common);
+        results[1] = ~crc32c_hardware((uint32_t) crc1, &data[1][common], sizes[1] - common);
+        results[2] = ~crc32c_hardware((uint32_t) crc2, &data[2][common], sizes[2] - common);
+    }
+
+#endif
+}
+
+uint32_t lnl::crc32c(const uint8_t* data, size_t size) {
+#ifdef CRC32C_HARDWARE
+    if (has_hardware_crc32c()) {
+        return ~crc32c_hardware(UINT32_MAX, data, size);
+    }
+#endif
+
+    return ~crc32c_software(UINT32_MAX, data, size);
+}
+
+void lnl::crc32c_batch(const uint8_t* const* data, const size_t* sizes, uint32_t* results, size_t count) {
+    size_t i = 0;
+
+#ifdef CRC32C_HARDWARE
+    if (has_hardware_crc32c()) {
+        for (; i + 3 <= count; i += 3) {
+            crc32c_hardware_3(&data[i], &sizes[i], &results[i]);
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        results[i] = crc32c(data[i], sizes[i]);
+    }
+}
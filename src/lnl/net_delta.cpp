@@ -0,0 +1,123 @@
+#include <lnl/net_delta.h>
+#include <lnl/net_bitmap.h>
+#include <lnl/net_varint.h>
+#include <lnl/net_xor.h>
+
+#include <algorithm>
+
+namespace {
+    //first position at or after pos whose byte is (zero ? zero : not zero), size if there is none
+    template <bool zero>
+    size_t find_byte(const uint8_t* data, size_t pos, size_t size) {
+#if defined(__AVX2__)
+        auto zeroes256 = _mm256_setzero_si256();
+
+        for (; pos + 32 <= size; pos += 32) {
+            auto equal = (uint32_t) _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) &data[pos]), zeroes256));
+            auto mask = zero ? equal : ~equal;
+
+            if (mask != 0) {
+                return pos + lnl::count_trailing_zeros(mask);
+            }
+        }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+        auto zeroes128 = _mm_setzero_si128();
+
+        for (; pos + 16 <= size; pos += 16) {
+            auto equal = (uint32_t) _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) &data[pos]), zeroes128));
+            auto mask = zero ? equal : ~equal & 0xFFFFu;
+
+            if (mask != 0) {
+                return pos + lnl::count_trailing_zeros(mask);
+            }
+        }
+#endif
+
+        for (; pos < size && (data[pos] == 0) != zero; ++pos) {}
+
+        return pos;
+    }
+}
+
+bool lnl::net_delta_codec::encode(const uint8_t* baseline, size_t baselineSize,
+                                  const uint8_t* data, size_t size,
+                                  uint8_t* dst, size_t capacity, size_t& encodedSize) {
+    if (m_xor.size() < size) {
+        m_xor.resize(size);
+    }
+
+    auto x = m_xor.data();
+    memcpy(x, data, size);
+    xor_into(x, baseline, std::min(baselineSize, size));
+
+    size_t written = 0;
+
+    for (size_t pos = 0; pos < size;) {
+        auto literalStart = find_byte<false>(x, pos, size);
+
+        if (literalStart == size) {
+            break;
+        }
+
+        auto literalEnd = find_byte<true>(x, literalStart, size);
+
+        while (literalEnd < size) {
+            auto zeroEnd = find_byte<false>(x, literalEnd, size);
+
+            if (zeroEnd == size || zeroEnd - literalEnd >= MIN_ZERO_RUN) {
+                break;
+            }
+
+            literalEnd = find_byte<true>(x, zeroEnd, size);
+        }
+
+        auto literalSize = literalEnd - literalStart;
+
+        if (!write_varint(dst, capacity, written, literalStart - pos) ||
+            !write_varint(dst, capacity, written, literalSize) ||
+            written + literalSize > capacity) {
+            return false;
+        }
+
+        memcpy(&dst[written], &x[literalStart], literalSize);
+        written += literalSize;
+        pos = literalEnd;
+    }
+
+    encodedSize = written;
+    return true;
+}
+
+bool lnl::net_delta_codec::decode(const uint8_t* baseline, size_t baselineSize,
+                                  const uint8_t* src, size_t srcSize,
+                                  uint8_t* dst, size_t size) {
+    auto copied = std::min(baselineSize, size);
+    memcpy(dst, baseline, copied);
+    memset(&dst[copied], 0, size - copied);
+
+    size_t pos = 0;
+    size_t srcPos = 0;
+
+    while (srcPos < srcSize) {
+        size_t zeroRun;
+        size_t literalSize;
+
+        if (!read_varint(src, srcSize, srcPos, zeroRun) ||
+            !read_varint(src, srcSize, srcPos, literalSize) ||
+            zeroRun > size - pos ||
+            literalSize > size - pos - zeroRun ||
+            literalSize > srcSize - srcPos) {
+            return false;
+        }
+
+        pos += zeroRun;
+        xor_into(&dst[pos], &src[srcPos], literalSize);
+        pos += literalSize;
+        srcPos += literalSize;
+    }
+
+    return true;
+}
@@ -0,0 +1,131 @@
+#include <lnl/net_fec.h>
+#include <lnl/net_bitmap.h>
+#include <lnl/net_xor.h>
+
+#include <algorithm>
+
+void lnl::net_fec_encoder::wrap(const lnl::net_packet* packet, lnl::net_packet* dst) {
+    dst->resize(PACKET_PROPERTY::FEC_DATA, packet->size());
+    dst->set_value_at(m_group, 1);
+    dst->set_value_at(m_count, 3);
+    dst->copy_from(packet->data(), 0, net_constants::FEC_DATA_HEADER_SIZE, packet->size());
+
+    xor_into(m_parity.data(), packet->data(), packet->size());
+    m_size_xor ^= (uint16_t) packet->size();
+    m_max_size = std::max(m_max_size, packet->size());
+    m_count++;
+}
+
+void lnl::net_fec_encoder::write_repair(lnl::net_packet* dst) {
+    dst->resize(PACKET_PROPERTY::FEC_REPAIR, m_max_size);
+    dst->set_value_at(m_group, 1);
+    dst->set_value_at(m_count, 3);
+    dst->set_value_at(m_size_xor, 4);
+    dst->copy_from(m_parity.data(), 0, net_constants::FEC_REPAIR_HEADER_SIZE, m_max_size);
+
+    memset(m_parity.data(), 0, m_max_size);
+    m_group++;
+    m_count = 0;
+    m_size_xor = 0;
+    m_max_size = 0;
+}
+
+size_t lnl::net_fec_decoder::add(const lnl::net_packet* packet) {
+    auto group = get_group(packet->get_value_at<uint16_t>(1));
+
+    if (!group || group->done) {
+        return 0;
+    }
+
+    auto isRepair = packet->property() == PACKET_PROPERTY::FEC_REPAIR;
+    auto headerSize = packet->get_header_size();
+    auto size = packet->size() - headerSize;
+    auto value = packet->data()[3];
+
+    auto maxValue = isRepair ? net_constants::MAX_FEC_GROUP_SIZE : net_constants::MAX_FEC_GROUP_SIZE - 1;
+
+    if (size > m_max_packet_size || value > maxValue) {
+        return 0;
+    }
+
+    if (isRepair) {
+        if (group->size != 0 || value == 0) {
+            return 0;
+        }
+
+        group->size = value;
+        group->size_xor ^= packet->get_value_at<uint16_t>(4);
+    } else {
+        if ((group->received & (1u << value)) != 0) {
+            return 0;
+        }
+
+        group->received |= 1u << value;
+        group->size_xor ^= (uint16_t) size;
+    }
+
+    xor_into(group->parity.data(), &packet->data()[headerSize], size);
+    group->max_size = std::max(group->max_size, size);
+
+    return try_recover(*group);
+}
+
+void lnl::net_fec_decoder::copy_recovered(uint8_t* dst) const {
+    memcpy(dst, m_recovered->parity.data(), m_recovered->size_xor);
+}
+
+lnl::net_fec_decoder::group* lnl::net_fec_decoder::get_group(uint16_t id) {
+    auto& group = m_groups[id % GROUP_SLOTS];
+
+    if (group.id == id) {
+        return &group;
+    }
+
+    //a slot only moves forward, packets of groups it already replaced are too late
+    if (group.id >= 0 && (int16_t) (id - (uint16_t) group.id) < 0) {
+        return nullptr;
+    }
+
+    if (group.parity.empty()) {
+        group.parity.resize(m_max_packet_size, 0);
+    } else {
+        memset(group.parity.data(), 0, group.max_size);
+    }
+
+    group.id = id;
+    group.received = 0;
+    group.size = 0;
+    group.done = false;
+    group.size_xor = 0;
+    group.max_size = 0;
+
+    return &group;
+}
+
+size_t lnl::net_fec_decoder::try_recover(group& group) {
+    if (group.size == 0) {
+        return 0;
+    }
+
+    auto mask = group.size >= 32 ? ~0u : (1u << group.size) - 1;
+    auto received = pop_count(group.received & mask);
+
+    if (received >= group.size) {
+        group.done = true;
+        return 0;
+    }
+
+    if (received + 1 != group.size) {
+        return 0;
+    }
+
+    //everything but the missing packet cancelled out of the parity
+    group.done = true;
+
+    if (group.size_xor == 0 || group.size_xor > group.max_size) {
+        return 0;
+    }
+
+    m_recovered = &group;
+    return group.size_xor;
+}
@@ -1,8 +1,14 @@
 #include <lnl/net_manager.h>
 #include <lnl/net_constants.h>
+#include <lnl/net_crc32c.h>
 #include <lnl/packets/net_connect_request_packet.h>
 #include <lnl/packets/net_connect_accept_packet.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+
 #ifdef WIN32
 
 #include <MSWSock.h> //for SIO_UDP_CONNRESET
@@ -22,15 +28,32 @@
 
 #endif
 
+namespace {
+    //seconds of the steady clock, cookies are only checked by the manager that issued them
+    uint32_t get_cookie_time() {
+        return (uint32_t) std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
 
 lnl::net_manager::net_manager(net_event_listener* listener)
         : m_listener(listener) {
     m_peers_array.resize(32);
+
+    std::random_device device;
+
+    for (auto& byte: m_cookie_secret) {
+        byte = (uint8_t) device();
+    }
 }
 
 lnl::net_manager::~net_manager() {
     m_running = false;
 
+    m_logic_signal.notify();
+    wake_receive_thread();
+
     if (m_receive_thread.joinable()) {
         m_receive_thread.join();
     }
@@ -39,6 +62,13 @@ lnl::net_manager::~net_manager() {
         m_logic_thread.join();
     }
 
+#ifdef WIN32
+    if (m_wakeup_socket != INVALID_SOCKET) {
+        closesocket(m_wakeup_socket);
+        m_wakeup_socket = INVALID_SOCKET;
+    }
+#endif
+
     shutdown(m_socket, SHUT_RDWR);
     close(m_socket);
 
@@ -88,6 +118,21 @@ bool lnl::net_manager::start(const sockaddr_in& addr) {
     }
 #endif
 
+    switch (mtu_profile) {
+        case MTU_PROFILE::INTERNET:
+            m_mtu_count = net_constants::INTERNET_MTU_COUNT;
+            break;
+        case MTU_PROFILE::JUMBO:
+            m_mtu_count = net_constants::JUMBO_MTU_COUNT;
+            break;
+        case MTU_PROFILE::LOOPBACK:
+            m_mtu_count = net_constants::POSSIBLE_MTU.size();
+            break;
+    }
+
+    m_reply_limiter.set_rate(unconnected_reply_rate, unconnected_reply_burst);
+    m_connect_request_limiter.set_rate(connect_request_rate, connect_request_burst);
+
     m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
     if (m_socket == INVALID_SOCKET) {
@@ -101,6 +146,24 @@ bool lnl::net_manager::start(const sockaddr_in& addr) {
         return false;
     }
 
+#ifdef WIN32
+    m_wakeup_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    struct sockaddr_in wakeupAddress{};
+    wakeupAddress.sin_family = AF_INET;
+    wakeupAddress.sin_addr.S_un.S_addr = htonl(INADDR_LOOPBACK);
+    int wakeupAddressSize = sizeof(wakeupAddress);
+
+    //connected to itself, so a plain send() wakes the select in socket_poll
+    if (m_wakeup_socket == INVALID_SOCKET ||
+        bind(m_wakeup_socket, (sockaddr*) &wakeupAddress, sizeof(wakeupAddress)) == SOCKET_ERROR ||
+        getsockname(m_wakeup_socket, (sockaddr*) &wakeupAddress, &wakeupAddressSize) == SOCKET_ERROR ||
+        connect(m_wakeup_socket, (sockaddr*) &wakeupAddress, sizeof(wakeupAddress)) == SOCKET_ERROR) {
+        m_logger.log("Cannot create wakeup socket: %p", GET_SOCK_ERROR());
+        return false;
+    }
+#endif
+
     m_running = true;
 
     m_receive_thread = std::thread(&net_manager::receive_logic, this);
@@ -174,6 +237,13 @@ bool lnl::net_manager::bind_socket(const sockaddr_in& addr) {
         return false;
     }
 
+#ifdef __linux__
+    //sets DF without clamping sends to the cached path mtu, so oversized mtu probes get lost instead of fragmented
+    if (!set_socket_option(IPPROTO_IP, IP_MTU_DISCOVER, IP_PMTUDISC_PROBE)) {
+        m_logger.log("Cannot set IP_MTU_DISCOVER to IP_PMTUDISC_PROBE %i", GET_SOCK_ERROR());
+    }
+#endif
+
 #ifdef __APPLE__
     if (!set_socket_option(IPPROTO_IP, IP_DONTFRAGMENT, true)) {
         m_logger.log("Cannot set IP_DONTFRAGMENT");
@@ -197,29 +267,194 @@ bool lnl::net_manager::bind_socket(const sockaddr_in& addr) {
 }
 
 void lnl::net_manager::receive_logic() {
-    net_address addr;
+    std::array<net_packet*, RECEIVE_BATCH_SIZE> packets{};
+    std::array<net_address, RECEIVE_BATCH_SIZE> addresses;
+    std::array<bool, RECEIVE_BATCH_SIZE> waitingForKeys{};
 
     while (m_running) {
         if (get_socket_available_data() == 0 && !socket_poll()) {
             continue;
         }
 
-        auto addrLen = (socklen_t) sizeof(addr.raw);
-        auto packet = pool_get_packet(net_constants::MAX_PACKET_SIZE);
+        auto count = receive_batch(packets.data(), addresses.data());
+
+        if (crc32c_enabled) {
+            verify_checksums(packets.data(), count);
+        }
+
+        if (encryption_enabled) {
+            waitingForKeys.fill(false);
+            open_datagrams(packets.data(), addresses.data(), count, waitingForKeys.data());
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            //a CONNECT_ACCEPT earlier in the batch may have brought the keys by now
+            if (waitingForKeys[i]) {
+                open_datagrams(&packets[i], &addresses[i], 1);
+            }
+
+            auto packet = packets[i];
+            packets[i] = nullptr;
+
+            if (!packet) {
+                continue;
+            }
+
+            if (simulate_packet_loss &&
+                (int32_t) (m_simulation_random() % 100) < simulation_packet_loss_chance) {
+                pool_recycle(packet);
+                continue;
+            }
+
+            on_message_received(packet, addresses[i]);
+        }
+    }
+
+    for (auto packet: packets) {
+        pool_recycle(packet);
+    }
+}
+
+size_t lnl::net_manager::receive_batch(net_packet** packets, net_address* addresses) {
+    auto bufferSize = (size_t) max_packet_size();
+
+#ifdef __linux__
+    std::array<mmsghdr, RECEIVE_BATCH_SIZE> messages{};
+    std::array<iovec, RECEIVE_BATCH_SIZE> buffers{};
+
+    for (size_t i = 0; i < RECEIVE_BATCH_SIZE; ++i) {
+        if (!packets[i]) {
+            packets[i] = pool_get_packet(0);
+        }
+
+        //the packet is sized to what arrived, so recycling clears only that
+        packets[i]->reserve(bufferSize);
+        buffers[i] = {packets[i]->data(), bufferSize};
+        messages[i].msg_hdr.msg_name = &addresses[i].raw;
+        messages[i].msg_hdr.msg_namelen = sizeof(addresses[i].raw);
+        messages[i].msg_hdr.msg_iov = &buffers[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    //the first datagram is known to be there, the rest is whatever queued up behind it
+    auto count = recvmmsg(m_socket, messages.data(), RECEIVE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+    if (count == SOCKET_ERROR) {
+        auto errorCode = GET_SOCK_ERROR();
+
+        if (errorCode != EAGAIN && errorCode != EWOULDBLOCK) {
+            m_logger.log("recvmmsg failed: %p", errorCode);
+        }
+
+        return 0;
+    }
+
+    for (size_t i = 0; i < (size_t) count; ++i) {
+        packets[i]->resize(messages[i].msg_len);
+    }
+
+    return count;
+#else
+    if (!packets[0]) {
+        packets[0] = pool_get_packet(0);
+    }
+
+    packets[0]->reserve(bufferSize);
+    auto addrLen = (socklen_t) sizeof(addresses[0].raw);
+
+    auto size = recvfrom(m_socket,
+                         (char*) packets[0]->data(), (int) bufferSize,
+                         0, (sockaddr*) &addresses[0].raw, &addrLen);
+
+    if (size == SOCKET_ERROR) {
+        m_logger.log("recvfrom failed: %p", GET_SOCK_ERROR());
+        return 0;
+    }
+
+    packets[0]->resize(size);
+    return 1;
+#endif
+}
+
+void lnl::net_manager::verify_checksums(net_packet** packets, size_t count) {
+    std::array<const uint8_t*, RECEIVE_BATCH_SIZE> data{};
+    std::array<size_t, RECEIVE_BATCH_SIZE> sizes{};
+    std::array<uint32_t, RECEIVE_BATCH_SIZE> checksums{};
+
+    for (size_t i = 0; i < count; ++i) {
+        auto size = packets[i]->size();
+        data[i] = packets[i]->data();
+        sizes[i] = size >= net_constants::CRC32C_SIZE ? size - net_constants::CRC32C_SIZE : 0;
+    }
+
+    crc32c_batch(data.data(), sizes.data(), checksums.data(), count);
+
+    for (size_t i = 0; i < count; ++i) {
+        auto packet = packets[i];
+
+        if (packet->size() < net_constants::HEADER_SIZE + net_constants::CRC32C_SIZE ||
+            packet->get_value_at<uint32_t>(sizes[i]) != checksums[i]) {
+            m_corrupted_packets++;
+            pool_recycle(packet);
+            packets[i] = nullptr;
+            continue;
+        }
+
+        packet->resize(sizes[i]);
+    }
+}
+
+void lnl::net_manager::open_datagrams(net_packet** packets, const net_address* addresses, size_t count,
+                                      bool* waitingForKeys) {
+    std::array<net_aead_job, RECEIVE_BATCH_SIZE> jobs;
+    std::array<size_t, RECEIVE_BATCH_SIZE> slots{};
+    std::array<std::shared_ptr<net_peer>, RECEIVE_BATCH_SIZE> peers;
+    size_t jobCount = 0;
 
-        auto size = recvfrom(m_socket,
-                             (char*) packet->data(), net_constants::MAX_PACKET_SIZE,
-                             0, (sockaddr*) &addr.raw, &addrLen);
+    for (size_t i = 0; i < count; ++i) {
+        auto packet = packets[i];
+
+        if (!packet || packet->size() < net_constants::HEADER_SIZE || !net_peer::is_sealed(packet->property())) {
+            continue;
+        }
+
+        auto peer = try_get_peer(addresses[i]);
+
+        //unknown addresses get PEER_NOT_FOUND as without encryption, a peer waiting for its keys may be rejected
+        if (!peer || (!peer->m_open_cipher && packet->property() == PACKET_PROPERTY::DISCONNECT)) {
+            continue;
+        }
+
+        if (!peer->m_open_cipher && waitingForKeys) {
+            waitingForKeys[i] = true;
+            continue;
+        }
 
-        if (size == SOCKET_ERROR) {
-            m_logger.log("recvfrom failed: %p", GET_SOCK_ERROR());
+        if (!peer->make_open_job(packet, jobs[jobCount])) {
+            m_unauthenticated_packets++;
             pool_recycle(packet);
+            packets[i] = nullptr;
             continue;
         }
 
-        packet->resize(size);
+        slots[jobCount] = i;
+        peers[jobCount] = std::move(peer);
+        jobCount++;
+    }
+
+    net_chacha20_poly1305::open_batch(jobs.data(), jobCount);
+
+    for (size_t job = 0; job < jobCount; ++job) {
+        auto i = slots[job];
+
+        if (!jobs[job].valid || !peers[job]->accept_nonce(jobs[job].nonce)) {
+            m_unauthenticated_packets++;
+            pool_recycle(packets[i]);
+            packets[i] = nullptr;
+            continue;
+        }
 
-        on_message_received(packet, addr);
+        packets[i]->resize(packets[i]->size() - net_constants::ENCRYPTION_TRAILER_SIZE);
     }
 }
 
@@ -228,11 +463,31 @@ void lnl::net_manager::update_logic() {
     net_stopwatch stopwatch;
     stopwatch.start();
 
+    auto nextUpdate = net_signal::clock::now();
+
     while (m_running) {
+        auto now = net_signal::clock::now();
+
+        if (now < nextUpdate) {
+            //woken up before the tick: only push out what was queued since the last pass
+            for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+                if (netPeer->connection_state() == CONNECTION_STATE::CONNECTED) {
+                    netPeer->process_send_queues();
+                }
+            }
+
+            wait_logic(nextUpdate);
+            continue;
+        }
+
         auto elapsed = stopwatch.milliseconds();
         elapsed = elapsed <= 0 ? 1 : elapsed;
         stopwatch.restart();
 
+        if (max_egress_rate > 0.) {
+            distribute_egress_budget(elapsed);
+        }
+
         for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
             if (netPeer->connection_state() == CONNECTION_STATE::DISCONNECTED &&
                 netPeer->m_time_since_last_packet > disconnect_timeout) {
@@ -242,6 +497,10 @@ void lnl::net_manager::update_logic() {
             }
         }
 
+        if (max_egress_rate > 0.) {
+            redistribute_unused_egress(elapsed);
+        }
+
         if (!peersToRemove.empty()) {
             net_mutex_guard guard(m_peers_mutex);
             for (auto& addr: peersToRemove) {
@@ -250,17 +509,209 @@ void lnl::net_manager::update_logic() {
             peersToRemove.clear();
         }
 
-        auto sleepTime = update_time - stopwatch.milliseconds();
+        nextUpdate = now + std::chrono::milliseconds(update_time);
 
-        if (sleepTime <= 0) {
+        wait_logic(nextUpdate);
+    }
+}
+
+void lnl::net_manager::distribute_egress_budget(int32_t elapsed) {
+    auto budget = max_egress_rate * elapsed / 1000.;
+    auto totalWeight = 0.;
+
+    for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+        if (netPeer->connection_state() == CONNECTION_STATE::CONNECTED) {
+            totalWeight += netPeer->weight();
+        }
+    }
+
+    if (totalWeight <= 0.) {
+        return;
+    }
+
+    //weighted share per tick, idle peers keep at most a couple of ticks worth for sends between ticks
+    for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+        if (netPeer->connection_state() != CONNECTION_STATE::CONNECTED) {
             continue;
         }
 
-        //consider timeBeginPeriod(1) for win32
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+        auto share = budget * netPeer->weight() / totalWeight;
+        netPeer->add_egress_credit(share, share * MAX_EGRESS_CREDIT_TICKS);
     }
 }
 
+void lnl::net_manager::redistribute_unused_egress(int32_t elapsed) {
+    auto budget = max_egress_rate * elapsed / 1000.;
+    auto totalWeight = 0.;
+    auto blockedWeight = 0.;
+
+    for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+        if (netPeer->connection_state() != CONNECTION_STATE::CONNECTED) {
+            continue;
+        }
+
+        totalWeight += netPeer->weight();
+
+        if (netPeer->is_egress_blocked()) {
+            blockedWeight += netPeer->weight();
+        }
+    }
+
+    if (blockedWeight <= 0.) {
+        return;
+    }
+
+    //peers that didn't use their share give it to the backlogged ones, keeping one tick as a reserve
+    auto unused = 0.;
+
+    for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+        if (netPeer->connection_state() == CONNECTION_STATE::CONNECTED && !netPeer->is_egress_blocked()) {
+            unused += netPeer->take_unused_egress_credit(budget * netPeer->weight() / totalWeight);
+        }
+    }
+
+    if (unused <= 0.) {
+        return;
+    }
+
+    for (auto netPeer = m_head_peer; netPeer; netPeer = netPeer->m_next_peer) {
+        if (netPeer->connection_state() != CONNECTION_STATE::CONNECTED || !netPeer->is_egress_blocked()) {
+            continue;
+        }
+
+        auto extra = unused * netPeer->weight() / blockedWeight;
+        netPeer->add_egress_credit(extra, extra + budget * MAX_EGRESS_CREDIT_TICKS);
+        netPeer->process_send_queues();
+    }
+}
+
+lnl::net_connect_extensions lnl::net_manager::local_extensions() const {
+    net_connect_extensions extensions;
+
+    if (compound_acks_enabled) {
+        extensions.set(PROTOCOL_FEATURE::COMPOUND_ACK);
+    }
+
+    if (piggyback_acks_enabled) {
+        extensions.set(PROTOCOL_FEATURE::PIGGYBACK_ACK);
+    }
+
+    if (fec_group_size > 0) {
+        extensions.set(PROTOCOL_FEATURE::FEC);
+    }
+
+    if (reliable_bundling_enabled) {
+        extensions.set(PROTOCOL_FEATURE::RELIABLE_BUNDLE);
+    }
+
+    if (compact_headers_enabled) {
+        extensions.set(PROTOCOL_FEATURE::COMPACT_HEADER);
+    }
+
+    if (compression_enabled) {
+        extensions.set(PROTOCOL_FEATURE::COMPRESSION);
+    }
+
+    if (encryption_enabled) {
+        extensions.set(PROTOCOL_FEATURE::ENCRYPTION);
+    }
+
+    //only sent when some channel differs from the default, the rest is implied
+    for (uint8_t i = 0; i < channels_count; ++i) {
+        extensions.window_sizes.push_back((uint8_t) (get_channel_window_size(i) / net_constants::DEFAULT_WINDOW_SIZE));
+    }
+
+    while (!extensions.window_sizes.empty() && extensions.window_sizes.back() == 1) {
+        extensions.window_sizes.pop_back();
+    }
+
+    return extensions;
+}
+
+void lnl::net_manager::wait_logic(net_signal::clock::time_point nextUpdate) {
+    auto scheduled = m_scheduled_wakeup.exchange(INT64_MAX);
+    auto deadline = nextUpdate;
+
+    if (scheduled < nextUpdate.time_since_epoch().count()) {
+        deadline = net_signal::clock::time_point(net_signal::clock::duration(scheduled));
+    }
+
+    m_logic_signal.wait_until(deadline);
+}
+
+void lnl::net_manager::schedule_logic_wakeup(net_signal::clock::time_point time) {
+    auto value = (int64_t) std::chrono::duration_cast<net_signal::clock::duration>(time.time_since_epoch()).count();
+    auto current = m_scheduled_wakeup.load();
+
+    while (value < current) {
+        if (m_scheduled_wakeup.compare_exchange_weak(current, value)) {
+            //the logic thread may already be sleeping with a later deadline
+            m_logic_signal.notify();
+            return;
+        }
+    }
+}
+
+void lnl::net_manager::set_channel_window_size(uint8_t channelNumber, int32_t windowSize) {
+    if (channelNumber >= m_channel_window_sizes.size()) {
+        m_channel_window_sizes.resize(channelNumber + 1, 0);
+    }
+
+    m_channel_window_sizes[channelNumber] = windowSize;
+}
+
+void lnl::net_manager::set_channel_priority(uint8_t channelNumber, uint8_t priority, uint32_t weight) {
+    if (channelNumber >= m_channel_schedules.size()) {
+        m_channel_schedules.resize(channelNumber + 1);
+    }
+
+    m_channel_schedules[channelNumber].priority = std::min<uint8_t>(priority,
+                                                                    net_constants::CHANNEL_PRIORITY_LEVELS - 1);
+    m_channel_schedules[channelNumber].weight = std::max<uint32_t>(weight, 1);
+}
+
+void lnl::net_manager::set_channel_dictionary(uint8_t channelNumber, const std::vector<uint8_t>& dictionary) {
+    if (channelNumber >= m_channel_dictionaries.size()) {
+        m_channel_dictionaries.resize(channelNumber + 1);
+    }
+
+    if (dictionary.empty()) {
+        m_channel_dictionaries[channelNumber].reset();
+    } else {
+        m_channel_dictionaries[channelNumber] = std::make_unique<net_lz_dictionary>(dictionary.data(),
+                                                                                   dictionary.size());
+    }
+}
+
+const lnl::net_lz_dictionary* lnl::net_manager::get_channel_dictionary(uint8_t channelNumber) const {
+    return channelNumber < m_channel_dictionaries.size() ? m_channel_dictionaries[channelNumber].get() : nullptr;
+}
+
+uint8_t lnl::net_manager::get_channel_priority(uint8_t channelNumber) const {
+    return channelNumber < m_channel_schedules.size() ? m_channel_schedules[channelNumber].priority : 0;
+}
+
+uint32_t lnl::net_manager::get_channel_weight(uint8_t channelNumber) const {
+    return channelNumber < m_channel_schedules.size() ? m_channel_schedules[channelNumber].weight : 1;
+}
+
+int32_t lnl::net_manager::get_channel_window_size(uint8_t channelNumber) const {
+    auto windowSize = reliable_window_size;
+
+    if (channelNumber < m_channel_window_sizes.size() && m_channel_window_sizes[channelNumber] > 0) {
+        windowSize = m_channel_window_sizes[channelNumber];
+    }
+
+    //slots are picked by sequence % window, only a power of two keeps them apart when sequences wrap
+    auto result = net_constants::DEFAULT_WINDOW_SIZE;
+
+    while (result < windowSize && result < net_constants::MAX_WINDOW_SIZE) {
+        result <<= 1;
+    }
+
+    return result;
+}
+
 lnl::net_packet* lnl::net_manager::pool_get_packet(size_t size) {
     net_packet* result;
 
@@ -287,7 +738,7 @@ void lnl::net_manager::pool_recycle(lnl::net_packet* packet) {
         return;
     }
 
-    if (packet->buffer_size() > net_constants::MAX_PACKET_SIZE || m_packet_pool_size >= packet_pool_size) {
+    if (packet->buffer_size() > (size_t) max_packet_size() || m_packet_pool_size >= packet_pool_size) {
         delete packet;
         return;
     }
@@ -317,21 +768,31 @@ bool lnl::net_manager::socket_poll() {
     fd_set rfds;
     FD_ZERO(&rfds);
     FD_SET(m_socket, &rfds);
+    FD_SET(m_wakeup_socket, &rfds);
 
     struct timeval timeout{};
     timeout.tv_sec = (int) (RECEIVE_POLLING_TIME / 1000000);
     timeout.tv_usec = (int) (RECEIVE_POLLING_TIME % 1000000);
 
-    auto result = select((int32_t) (m_socket + 1), &rfds, nullptr, nullptr,
-                         &timeout);
+    //the first argument is ignored on windows
+    if (select(0, &rfds, nullptr, nullptr, &timeout) <= 0) {
+        return false;
+    }
+
+    if (FD_ISSET(m_wakeup_socket, &rfds)) {
+        char wakeup;
+        recv(m_wakeup_socket, &wakeup, sizeof(wakeup), 0);
+    }
 
-    return result > 0;
+    return FD_ISSET(m_socket, &rfds);
 #else
-    struct pollfd pollfds[1];
+    struct pollfd pollfds[2];
     pollfds[0].fd = m_socket;
     pollfds[0].events = POLLIN;
+    pollfds[1].fd = m_receive_signal.native_handle();
+    pollfds[1].events = POLLIN;
 
-    if (poll(pollfds, 1, RECEIVE_POLLING_TIME / 1000) < 0) {
+    if (poll(pollfds, 2, RECEIVE_POLLING_TIME / 1000) < 0) {
         return false;
     }
 
@@ -339,6 +800,17 @@ bool lnl::net_manager::socket_poll() {
 #endif
 }
 
+void lnl::net_manager::wake_receive_thread() {
+#ifdef WIN32
+    if (m_wakeup_socket != INVALID_SOCKET) {
+        char wakeup = 0;
+        send(m_wakeup_socket, &wakeup, sizeof(wakeup), 0);
+    }
+#else
+    m_receive_signal.notify();
+#endif
+}
+
 void lnl::net_manager::on_message_received(lnl::net_packet* packet, net_address& addr) {
     if (!packet->verify()) {
         pool_recycle(packet);
@@ -353,7 +825,10 @@ void lnl::net_manager::on_message_received(lnl::net_packet* packet, net_address&
     switch (property) {
         case PACKET_PROPERTY::CONNECT_REQUEST: {
             if (net_connect_request_packet::get_protocol_id(packet) != net_constants::PROTOCOL_ID) {
-                send_raw_and_recycle(pool_get_with_property(PACKET_PROPERTY::INVALID_PROTOCOL), addr);
+                if (allow_unconnected_reply(addr)) {
+                    send_raw_and_recycle(pool_get_with_property(PACKET_PROPERTY::INVALID_PROTOCOL), addr);
+                }
+
                 pool_recycle(packet);
                 return;
             }
@@ -402,8 +877,30 @@ void lnl::net_manager::on_message_received(lnl::net_packet* packet, net_address&
 
     switch (property) {
         case PACKET_PROPERTY::CONNECT_REQUEST: {
+            if (!netPeer && !allow_connect_request(addr)) {
+                pool_recycle(packet);
+                break;
+            }
+
+            //nothing is allocated for an unknown address until it proves it receives what is sent to it
+            if (connect_cookies_enabled && !netPeer && !has_connect_cookie(packet, addr)) {
+                if (allow_unconnected_reply(addr)) {
+                    send_connect_challenge(packet, addr);
+                }
+
+                pool_recycle(packet);
+                break;
+            }
+
             auto connRequest = net_connect_request_packet::from_data(packet);
 
+            //no connection without keys when encrypting, whatever removed them from the request
+            if (connRequest && encryption_enabled &&
+                (!connRequest->extensions || !connRequest->extensions->has(PROTOCOL_FEATURE::ENCRYPTION) ||
+                 connRequest->extensions->key_salt == 0)) {
+                connRequest.reset();
+            }
+
             if (connRequest) {
                 process_connect_request(addr, netPeer, connRequest);
             } else {
@@ -461,12 +958,25 @@ void lnl::net_manager::on_message_received(lnl::net_packet* packet, net_address&
                                       : DISCONNECT_REASON::CONNECTION_REJECTED, 0, packet);
             } else {
                 pool_recycle(packet);
+
+                if (!allow_unconnected_reply(addr)) {
+                    break;
+                }
             }
 
             send_raw_and_recycle(pool_get_with_property(PACKET_PROPERTY::SHUTDOWN_OK), addr);
             break;
         }
 
+        case PACKET_PROPERTY::CONNECT_CHALLENGE: {
+            if (netPeer) {
+                netPeer->process_connect_challenge(packet);
+            }
+
+            pool_recycle(packet);
+            break;
+        }
+
         case PACKET_PROPERTY::CONNECT_ACCEPT: {
             if (!netPeer) {
                 pool_recycle(packet);
@@ -494,12 +1004,107 @@ void lnl::net_manager::on_message_received(lnl::net_packet* packet, net_address&
                 netPeer->process_packet(packet);
             } else {
                 pool_recycle(packet);
-                send_raw_and_recycle(pool_get_with_property(PACKET_PROPERTY::PEER_NOT_FOUND), addr);
+
+                if (allow_unconnected_reply(addr)) {
+                    send_raw_and_recycle(pool_get_with_property(PACKET_PROPERTY::PEER_NOT_FOUND), addr);
+                }
             }
         }
     }
 }
 
+void lnl::net_manager::make_connect_cookie(const lnl::net_address& address, int64_t connectTime, uint32_t issueTime,
+                                           uint8_t* cookie) const {
+    uint8_t input[sizeof(address.raw.sin_addr) + sizeof(address.raw.sin_port) + sizeof(connectTime) +
+                  sizeof(issueTime)];
+    size_t pos = 0;
+
+    memcpy(&input[pos], &address.raw.sin_addr, sizeof(address.raw.sin_addr));
+    pos += sizeof(address.raw.sin_addr);
+    memcpy(&input[pos], &address.raw.sin_port, sizeof(address.raw.sin_port));
+    pos += sizeof(address.raw.sin_port);
+    memcpy(&input[pos], &connectTime, sizeof(connectTime));
+    pos += sizeof(connectTime);
+    memcpy(&input[pos], &issueTime, sizeof(issueTime));
+
+    uint8_t mac[net_sha256::DIGEST_SIZE];
+    hmac_sha256(m_cookie_secret.data(), m_cookie_secret.size(), input, sizeof(input), mac);
+
+    memcpy(cookie, &issueTime, sizeof(issueTime));
+    memcpy(&cookie[sizeof(issueTime)], mac, net_constants::CONNECT_COOKIE_SIZE - sizeof(issueTime));
+}
+
+bool lnl::net_manager::has_connect_cookie(const lnl::net_packet* request, const lnl::net_address& address) const {
+    size_t trailerSize;
+    auto extensions = net_connect_extensions::read_from(request,
+                                                        net_constants::CONNECT_REQUEST_HEADER_SIZE +
+                                                        sizeof(address.raw),
+                                                        trailerSize);
+
+    if (!extensions || !extensions->cookie) {
+        return false;
+    }
+
+    auto& cookie = *extensions->cookie;
+    auto issueTime = *(uint32_t*) cookie.data();
+
+    if (get_cookie_time() - issueTime > CONNECT_COOKIE_LIFETIME) {
+        return false;
+    }
+
+    uint8_t expected[net_constants::CONNECT_COOKIE_SIZE];
+    make_connect_cookie(address, request->get_value_at<int64_t>(5), issueTime, expected);
+
+    uint8_t difference = 0;
+
+    for (size_t i = 0; i < sizeof(expected); ++i) {
+        difference |= expected[i] ^ cookie[i];
+    }
+
+    return difference == 0;
+}
+
+void lnl::net_manager::send_connect_challenge(const lnl::net_packet* request, lnl::net_address& address) {
+    //never larger than what it answers, so spoofed requests gain nothing by reflecting
+    if (request->size() < net_constants::CONNECT_CHALLENGE_SIZE) {
+        return;
+    }
+
+    auto connectTime = request->get_value_at<int64_t>(5);
+    auto challenge = pool_get_with_property(PACKET_PROPERTY::CONNECT_CHALLENGE,
+                                            net_constants::CONNECT_CHALLENGE_SIZE - net_constants::HEADER_SIZE);
+    challenge->set_value_at(connectTime, 1);
+    make_connect_cookie(address, connectTime, get_cookie_time(), &challenge->data()[9]);
+
+    m_connect_challenges++;
+    send_raw_and_recycle(challenge, address);
+}
+
+uint64_t lnl::net_manager::get_source_prefix(const lnl::net_address& address) const {
+    auto length = std::min<uint32_t>(rate_limit_prefix_length, 32);
+    auto mask = length == 0 ? 0 : UINT32_MAX << (32 - length);
+    return ntohl(address.raw.sin_addr.s_addr) & mask;
+}
+
+bool lnl::net_manager::allow_unconnected_reply(const lnl::net_address& address) {
+    if (!m_reply_limiter.enabled() || m_reply_limiter.try_acquire(get_source_prefix(address), get_current_time())) {
+        return true;
+    }
+
+    m_limited_replies++;
+    return false;
+}
+
+bool lnl::net_manager::allow_connect_request(const lnl::net_address& address) {
+    if (!m_connect_request_limiter.enabled() ||
+        m_connect_request_limiter.try_acquire(get_source_prefix(address), get_current_time())) {
+        return true;
+    }
+
+    m_limited_connect_requests++;
+    return false;
+}
+
 lnl::net_packet* lnl::net_manager::pool_get_with_property(lnl::PACKET_PROPERTY property, size_t size) {
     auto packet = pool_get_packet(net_packet::get_header_size(property) + size);
     packet->set_property(property);
@@ -517,10 +1122,37 @@ int32_t lnl::net_manager::send_raw(const uint8_t* data, size_t offset, size_t le
         return 0;
     }
 
-    auto result = sendto(m_socket,
-                         (const char*) &data[offset], (int) length,
-                         0,
-                         (sockaddr*) &endpoint.raw, sizeof(sockaddr_in));
+    int64_t result;
+
+    if (crc32c_enabled) {
+        //the checksum goes out as a second buffer of the same datagram instead of being copied after the packet
+        auto checksum = crc32c(&data[offset], length);
+#ifdef WIN32
+        WSABUF buffers[2] = {{(ULONG) length, (CHAR*) &data[offset]},
+                             {sizeof(checksum), (CHAR*) &checksum}};
+        DWORD sent = 0;
+
+        result = WSASendTo(m_socket, buffers, 2, &sent, 0,
+                           (sockaddr*) &endpoint.raw, sizeof(sockaddr_in), nullptr, nullptr) == SOCKET_ERROR
+                 ? SOCKET_ERROR
+                 : (int64_t) sent;
+#else
+        iovec buffers[2] = {{(void*) &data[offset], length},
+                            {&checksum, sizeof(checksum)}};
+        msghdr message{};
+        message.msg_name = &endpoint.raw;
+        message.msg_namelen = sizeof(sockaddr_in);
+        message.msg_iov = buffers;
+        message.msg_iovlen = 2;
+
+        result = sendmsg(m_socket, &message, 0);
+#endif
+    } else {
+        result = sendto(m_socket,
+                        (const char*) &data[offset], (int) length,
+                        0,
+                        (sockaddr*) &endpoint.raw, sizeof(sockaddr_in));
+    }
 
     if (result == SOCKET_ERROR) {
         auto errorCode = GET_SOCK_ERROR();
@@ -528,6 +1160,14 @@ int32_t lnl::net_manager::send_raw(const uint8_t* data, size_t offset, size_t le
         m_logger.log("sendto failed: %p", errorCode);
 #endif
         switch (errorCode) {
+#ifdef WIN32
+            case WSAEMSGSIZE:
+#elif __linux__
+            case EMSGSIZE:
+#endif
+                //larger than the interface mtu, only mtu probes get that large
+                return SEND_RESULT_TOO_LARGE;
+
 #ifdef WIN32
             case WSAEHOSTUNREACH:
             case WSAENETUNREACH: {
@@ -566,7 +1206,7 @@ int32_t lnl::net_manager::send_raw(const uint8_t* data, size_t offset, size_t le
         return 0;
     }
 
-    return result;
+    return (int32_t) result;
 }
 
 void lnl::net_manager::create_event(net_event_create_args& args) {
@@ -801,10 +1441,26 @@ void lnl::net_manager::message_delivered(const lnl::net_address& address, void*
     net_event_create_args messageDeliveredEvent{};
     messageDeliveredEvent.type = NET_EVENT_TYPE::MESSAGE_DELIVERED;
     messageDeliveredEvent.peer = peer;
+    messageDeliveredEvent.userData = userData;
 
     create_event(messageDeliveredEvent);
 }
 
+void lnl::net_manager::message_lost(const lnl::net_address& address, void* userData) {
+    std::shared_ptr<net_peer> peer = try_get_peer(address);
+
+    if (!peer) {
+        return;
+    }
+
+    net_event_create_args messageLostEvent{};
+    messageLostEvent.type = NET_EVENT_TYPE::MESSAGE_LOST;
+    messageLostEvent.peer = peer;
+    messageLostEvent.userData = userData;
+
+    create_event(messageLostEvent);
+}
+
 void lnl::net_manager::remove_peer(const lnl::net_address& address) {
     net_mutex_guard guard(m_peers_mutex);
     remove_peer_internal(address);
@@ -936,6 +1592,11 @@ void lnl::net_manager::process_event(lnl::net_event& event) {
             m_listener->on_message_delivered(event.peer, event.userData);
             break;
         }
+
+        case NET_EVENT_TYPE::MESSAGE_LOST: {
+            m_listener->on_message_lost(event.peer, event.userData);
+            break;
+        }
     }
 
     if (auto_recycle) {
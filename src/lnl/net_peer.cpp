@@ -2,23 +2,75 @@
 #include <lnl/net_manager.h>
 #include <lnl/net_connection_request.h>
 #include <lnl/net_utils.h>
+#include <lnl/net_varint.h>
 #include <lnl/packets/net_connect_accept_packet.h>
 #include <lnl/channels/net_reliable_channel.h>
 #include <lnl/channels/net_sequenced_channel.h>
+#include <lnl/channels/net_redundant_channel.h>
+#include <lnl/channels/net_notified_channel.h>
+#include <lnl/channels/net_delta_channel.h>
+#include <lnl/congestion/net_aimd_congestion_controller.h>
+#include <lnl/congestion/net_delay_congestion_controller.h>
+
+#include <random>
+
+namespace {
+    //never 0, which stands for no salt on the wire
+    uint64_t make_key_salt() {
+        std::random_device device;
+        uint64_t salt = 0;
+
+        while (salt == 0) {
+            salt = (uint64_t) device() << 32 | device();
+        }
+
+        return salt;
+    }
+}
 
 lnl::net_peer::net_peer(lnl::net_manager* netManager, const lnl::net_address& endpoint, int32_t id)
         : m_connection_state(CONNECTION_STATE::CONNECTED),
+          m_shutdown_packet(PACKET_PROPERTY::DISCONNECT, 0),
           m_pong_packet(PACKET_PROPERTY::PONG, 0),
           m_ping_packet(PACKET_PROPERTY::PING, 0),
-          m_merge_data(PACKET_PROPERTY::MERGED, net_constants::MAX_PACKET_SIZE),
-          m_shutdown_packet(PACKET_PROPERTY::DISCONNECT, 0) {
+          m_merge_data(PACKET_PROPERTY::MERGED, netManager->max_packet_size()),
+          m_compact_data(PACKET_PROPERTY::COMPACT_MERGED, netManager->max_packet_size()),
+          m_compression_buffer(netManager->max_packet_size()),
+          m_ack_buffer(PACKET_PROPERTY::COMPOUND_ACK, netManager->max_packet_size()),
+          m_fec_encoder(netManager->max_packet_size()),
+          m_fec_packet(PACKET_PROPERTY::FEC_DATA, netManager->max_packet_size()),
+          m_fec_decoder(netManager->max_packet_size()) {
     m_id = id;
     m_endpoint = endpoint;
     m_net_manager = netManager;
 
     reset_mtu();
 
-    m_channels.resize(netManager->channels_count * net_constants::CHANNEL_TYPE_COUNT);
+    if (netManager->encryption_enabled) {
+        m_seal_buffer.resize(netManager->max_packet_size());
+    }
+
+    //every single byte channel id, the extended ones are at the top
+    m_channels.resize(UINT8_MAX + 1);
+
+    if (netManager->congestion_controller_factory) {
+        m_congestion_controller = netManager->congestion_controller_factory();
+    } else {
+        switch (netManager->congestion_control) {
+            case CONGESTION_CONTROL::AIMD: {
+                m_congestion_controller = std::make_unique<net_aimd_congestion_controller>(netManager->max_packet_size());
+                break;
+            }
+
+            case CONGESTION_CONTROL::DELAY_BASED: {
+                m_congestion_controller = std::make_unique<net_delay_congestion_controller>(netManager->max_packet_size());
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
 }
 
 lnl::net_peer::net_peer(lnl::net_manager* netManager, lnl::net_connection_request* request, int32_t id)
@@ -27,9 +79,23 @@ lnl::net_peer::net_peer(lnl::net_manager* netManager, lnl::net_connection_reques
     m_connect_number = request->m_internal_packet->connection_number;
     m_remote_id = request->m_internal_packet->peer_id;
 
+    //only answer with extensions to peers that sent them
+    std::optional<net_connect_extensions> acceptExtensions;
+
+    if (request->m_internal_packet->extensions) {
+        m_extensions = request->m_internal_packet->extensions->intersect(netManager->local_extensions());
+        acceptExtensions = m_extensions;
+
+        if (m_extensions.has(PROTOCOL_FEATURE::ENCRYPTION)) {
+            m_key_salt = make_key_salt();
+            acceptExtensions->key_salt = m_key_salt;
+            init_encryption(request->m_internal_packet->extensions->key_salt, m_key_salt, true);
+        }
+    }
+
     m_connect_accept_packet = std::unique_ptr<net_packet>(
             net_connect_accept_packet::make(m_connect_time,
-                                            m_connect_number, id));
+                                            m_connect_number, id, acceptExtensions));
     netManager->send_raw(m_connect_accept_packet.get(), m_endpoint);
 
     m_connection_state = CONNECTION_STATE::CONNECTED;
@@ -46,6 +112,18 @@ lnl::net_peer::net_peer(lnl::net_manager* netManager, const lnl::net_address& en
             net_connect_request_packet::make(connectData,
                                              endpoint, m_connect_time,
                                              id));
+
+    auto extensions = netManager->local_extensions();
+
+    if (extensions.has(PROTOCOL_FEATURE::ENCRYPTION)) {
+        m_key_salt = make_key_salt();
+        extensions.key_salt = m_key_salt;
+    }
+
+    if (extensions.features != 0 || !extensions.window_sizes.empty()) {
+        extensions.write_to(m_connect_request_packet.get());
+    }
+
     m_connect_request_packet->set_connection_number(m_connect_number);
 
     m_net_manager->send_raw(m_connect_request_packet.get(), m_endpoint);
@@ -65,6 +143,11 @@ lnl::net_peer::~net_peer() {
         delete m_unreliable_channel.front();
         m_unreliable_channel.pop();
     }
+
+    while (!m_paced_queue.empty()) {
+        delete m_paced_queue.front();
+        m_paced_queue.pop();
+    }
 }
 
 lnl::SHUTDOWN_RESULT lnl::net_peer::shutdown(const std::optional<std::vector<uint8_t>>& rejectData,
@@ -97,7 +180,7 @@ lnl::SHUTDOWN_RESULT lnl::net_peer::shutdown(const std::optional<std::vector<uin
     }
 
     m_connection_state = CONNECTION_STATE::SHUTDOWN_REQUESTED;
-    m_net_manager->send_raw(&m_shutdown_packet, m_endpoint);
+    send_sealed(&m_shutdown_packet);
 
     return result;
 }
@@ -127,6 +210,16 @@ bool lnl::net_peer::process_connect_accept(const std::unique_ptr<net_connect_acc
 
     m_connect_number = packet->connection_number();
     m_remote_id = packet->peer_id();
+    //encryption can't be left out by whoever is in the middle, an accept without it is ignored
+    if (m_net_manager->encryption_enabled) {
+        if (!packet->extensions().has(PROTOCOL_FEATURE::ENCRYPTION) || packet->extensions().key_salt == 0) {
+            return false;
+        }
+
+        init_encryption(m_key_salt, packet->extensions().key_salt, false);
+    }
+
+    m_extensions = packet->extensions().intersect(m_net_manager->local_extensions());
 
     m_time_since_last_packet = 0;
 
@@ -135,6 +228,30 @@ bool lnl::net_peer::process_connect_accept(const std::unique_ptr<net_connect_acc
     return true;
 }
 
+void lnl::net_peer::process_connect_challenge(lnl::net_packet* packet) {
+    if (m_connection_state != CONNECTION_STATE::OUTGOING ||
+        packet->size() != net_constants::CONNECT_CHALLENGE_SIZE ||
+        packet->get_value_at<int64_t>(1) != m_connect_time) {
+        return;
+    }
+
+    auto request = m_connect_request_packet.get();
+    size_t trailerSize;
+    auto extensions = net_connect_extensions::read_from(request,
+                                                        net_constants::CONNECT_REQUEST_HEADER_SIZE +
+                                                        sizeof(m_endpoint.raw),
+                                                        trailerSize);
+
+    //a newer cookie replaces the old one, the server may have restarted or it expired
+    extensions->cookie.emplace();
+    memcpy(extensions->cookie->data(), &packet->data()[9], net_constants::CONNECT_COOKIE_SIZE);
+    request->resize(request->size() - trailerSize);
+    extensions->write_to(request);
+
+    m_connect_timer = 0;
+    m_net_manager->send_raw(request, m_endpoint);
+}
+
 void lnl::net_peer::process_packet(lnl::net_packet* packet) {
     auto isConnected = m_connection_state == CONNECTION_STATE::CONNECTED ||
                        m_connection_state == CONNECTION_STATE::OUTGOING;
@@ -187,11 +304,29 @@ void lnl::net_peer::process_packet(lnl::net_packet* packet) {
             break;
         }
 
+        case PACKET_PROPERTY::COMPACT_MERGED: {
+            net_compact_reader reader(packet);
+
+            while (reader.has_next()) {
+                auto mergedPacket = m_net_manager->pool_get_packet(0);
+
+                if (!reader.read_next(mergedPacket) || !mergedPacket->verify()) {
+                    m_net_manager->pool_recycle(mergedPacket);
+                    break;
+                }
+
+                process_packet(mergedPacket);
+            }
+
+            m_net_manager->pool_recycle(packet);
+            break;
+        }
+
         case PACKET_PROPERTY::PING: {
             if (relative_sequence_number(packet->sequence(), m_pong_packet.sequence()) > 0) {
                 m_pong_packet.set_value_at(get_current_time(), 3);
                 m_pong_packet.set_sequence(packet->sequence());
-                m_net_manager->send_raw(&m_pong_packet, m_endpoint);
+                send_sealed(&m_pong_packet);
             }
 
             m_net_manager->pool_recycle(packet);
@@ -205,7 +340,7 @@ void lnl::net_peer::process_packet(lnl::net_packet* packet) {
                 m_remote_delta = *(int64_t*) &packet->data()[3] +
                                  (elapsedMs * TICKS_PER_MILLISECOND) / 2 -
                                  get_current_time();
-                update_roundtrip_time(elapsedMs);
+                update_roundtrip_time((double) elapsedMs);
                 m_net_manager->connection_latency_updated(m_endpoint, elapsedMs / 2);
             }
 
@@ -215,25 +350,28 @@ void lnl::net_peer::process_packet(lnl::net_packet* packet) {
 
         case PACKET_PROPERTY::ACK:
         case PACKET_PROPERTY::CHANNELED: {
-            if (packet->channel_id() > m_channels.size()) {
-                m_net_manager->pool_recycle(packet);
-                break;
-            }
+            process_channeled_packet(packet);
+            break;
+        }
 
-            net_base_channel* channel = m_channels[packet->channel_id()];
+        case PACKET_PROPERTY::COMPOUND_ACK: {
+            process_compound_ack(packet);
+            break;
+        }
 
-            if (!channel && packet->property() != PACKET_PROPERTY::ACK) {
-                channel = create_channel(packet->channel_id());
-            }
+        case PACKET_PROPERTY::CHANNELED_ACK: {
+            process_piggybacked_ack(packet);
+            break;
+        }
 
-            if (channel) {
-                if (!channel->process_packet(packet)) {
-                    m_net_manager->pool_recycle(packet);
-                }
-            } else {
-                m_net_manager->pool_recycle(packet);
-            }
+        case PACKET_PROPERTY::FEC_DATA:
+        case PACKET_PROPERTY::FEC_REPAIR: {
+            process_fec_packet(packet);
+            break;
+        }
 
+        case PACKET_PROPERTY::COMPRESSED: {
+            process_compressed_packet(packet);
             break;
         }
 
@@ -251,11 +389,210 @@ void lnl::net_peer::process_packet(lnl::net_packet* packet) {
     }
 }
 
-void lnl::net_peer::update_roundtrip_time(int32_t roundTripTime) {
-    m_rtt += roundTripTime;
-    m_rtt_count++;
-    m_avg_rtt = m_rtt / m_rtt_count;
-    m_resend_delay = 25. + m_avg_rtt * 2.1;
+void lnl::net_peer::process_channeled_packet(lnl::net_packet* packet) {
+    if (packet->channel_id() >= m_channels.size()) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    net_base_channel* channel = m_channels[packet->channel_id()];
+
+    if (!channel && packet->property() != PACKET_PROPERTY::ACK) {
+        channel = create_channel(packet->channel_id());
+    }
+
+    if (channel) {
+        if (!channel->process_packet(packet)) {
+            m_net_manager->pool_recycle(packet);
+        }
+    } else {
+        m_net_manager->pool_recycle(packet);
+    }
+}
+
+void lnl::net_peer::process_compound_ack(lnl::net_packet* packet) {
+    //records are ack packets without the property byte, prefixed by their size
+    size_t pos = net_constants::HEADER_SIZE;
+
+    while (pos + 2 <= packet->size()) {
+        auto size = packet->get_value_at<uint16_t>(pos);
+        pos += 2;
+
+        if (packet->size() - pos < size) {
+            break;
+        }
+
+        auto ack = m_net_manager->pool_get_packet(net_constants::HEADER_SIZE + size);
+        ack->data()[0] = (uint8_t) PACKET_PROPERTY::ACK;
+        ack->copy_from(packet->data(), pos, net_constants::HEADER_SIZE, size);
+        pos += size;
+
+        if (!ack->verify()) {
+            m_net_manager->pool_recycle(ack);
+            break;
+        }
+
+        process_channeled_packet(ack);
+    }
+
+    m_net_manager->pool_recycle(packet);
+}
+
+void lnl::net_peer::process_piggybacked_ack(lnl::net_packet* packet) {
+    //[channeled packet][ack record][record size u16]
+    auto size = packet->size();
+
+    if (size < net_constants::CHANNELED_HEADER_SIZE + 2) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    size_t recordSize = packet->get_value_at<uint16_t>(size - 2);
+
+    if (recordSize + 2 > size - net_constants::CHANNELED_HEADER_SIZE) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    auto recordPos = size - 2 - recordSize;
+    auto ack = m_net_manager->pool_get_packet(net_constants::HEADER_SIZE + recordSize);
+    ack->data()[0] = (uint8_t) PACKET_PROPERTY::ACK;
+    ack->copy_from(packet->data(), recordPos, net_constants::HEADER_SIZE, recordSize);
+
+    if (ack->verify()) {
+        process_channeled_packet(ack);
+    } else {
+        m_net_manager->pool_recycle(ack);
+    }
+
+    packet->resize(recordPos);
+    packet->set_property(PACKET_PROPERTY::CHANNELED);
+
+    if (!packet->verify()) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    process_channeled_packet(packet);
+}
+
+void lnl::net_peer::process_fec_packet(lnl::net_packet* packet) {
+    auto recoveredSize = m_fec_decoder.add(packet);
+
+    if (packet->property() == PACKET_PROPERTY::FEC_DATA) {
+        auto size = packet->size() - net_constants::FEC_DATA_HEADER_SIZE;
+        auto inner = m_net_manager->pool_get_packet(size);
+        inner->copy_from(packet->data(), net_constants::FEC_DATA_HEADER_SIZE, 0, size);
+
+        if (inner->verify()) {
+            process_packet(inner);
+        } else {
+            m_net_manager->pool_recycle(inner);
+        }
+    }
+
+    m_net_manager->pool_recycle(packet);
+
+    if (recoveredSize == 0) {
+        return;
+    }
+
+    auto recovered = m_net_manager->pool_get_packet(recoveredSize);
+    m_fec_decoder.copy_recovered(recovered->data());
+
+    if (recovered->verify()) {
+        process_packet(recovered);
+    } else {
+        m_net_manager->pool_recycle(recovered);
+    }
+}
+
+void lnl::net_peer::process_compressed_packet(lnl::net_packet* packet) {
+    size_t pos = net_constants::HEADER_SIZE + 1;
+    size_t size;
+
+    if (packet->size() < pos ||
+        !read_varint(packet->data(), packet->size(), pos, size) ||
+        size < net_constants::HEADER_SIZE ||
+        size > (size_t) m_net_manager->max_packet_size()) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    auto dictionaryChannel = packet->data()[net_constants::HEADER_SIZE];
+    const net_lz_dictionary* dictionary = nullptr;
+
+    if (dictionaryChannel > 0) {
+        dictionary = m_net_manager->get_channel_dictionary(dictionaryChannel - 1);
+
+        if (!dictionary) {
+            m_net_manager->pool_recycle(packet);
+            return;
+        }
+    }
+
+    auto decompressed = m_net_manager->pool_get_packet(size);
+    auto start = std::chrono::steady_clock::now();
+    auto isDecompressed = net_lz_codec::decompress(&packet->data()[pos], packet->size() - pos,
+                                                   decompressed->data(), size, dictionary);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    {
+        net_mutex_guard guard(m_compression_stats_mutex);
+        m_compression_stats.decompressed_packets++;
+        m_compression_stats.decompress_time += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    m_net_manager->pool_recycle(packet);
+
+    //a compressed datagram never holds another one
+    if (!isDecompressed || !decompressed->verify() || decompressed->property() == PACKET_PROPERTY::COMPRESSED) {
+        m_net_manager->pool_recycle(decompressed);
+        return;
+    }
+
+    process_packet(decompressed);
+}
+
+void lnl::net_peer::update_roundtrip_time(double roundTripTime) {
+    net_mutex_guard guard(m_rtt_mutex);
+
+    m_rtt_estimator.add_sample(roundTripTime);
+    //resend deadlines are only checked once per logic tick
+    m_resend_delay = m_rtt_estimator.rto(m_net_manager->update_time, MIN_RESEND_DELAY, MAX_RESEND_DELAY);
+}
+
+int32_t lnl::net_peer::get_channel_id(uint8_t channelNumber, lnl::DELIVERY_METHOD method) const {
+    if ((uint8_t) method < net_constants::CHANNEL_TYPE_COUNT) {
+        return channelNumber * net_constants::CHANNEL_TYPE_COUNT + (int32_t) method;
+    }
+
+    auto extended = (int32_t) method - (int32_t) DELIVERY_METHOD::UNRELIABLE - 1;
+    auto channelId = UINT8_MAX - channelNumber * net_constants::EXTENDED_CHANNEL_TYPE_COUNT - extended;
+
+    //taken by a basic channel when there are too many of them
+    if (channelId < m_net_manager->channels_count * net_constants::CHANNEL_TYPE_COUNT) {
+        return -1;
+    }
+
+    return channelId;
+}
+
+uint8_t lnl::net_peer::get_channel_number(uint8_t channelId) const {
+    if (channelId < m_net_manager->channels_count * net_constants::CHANNEL_TYPE_COUNT) {
+        return (uint8_t) (channelId / net_constants::CHANNEL_TYPE_COUNT);
+    }
+
+    return (uint8_t) ((UINT8_MAX - channelId) / net_constants::EXTENDED_CHANNEL_TYPE_COUNT);
+}
+
+lnl::DELIVERY_METHOD lnl::net_peer::get_channel_method(uint8_t channelId) const {
+    if (channelId < m_net_manager->channels_count * net_constants::CHANNEL_TYPE_COUNT) {
+        return (DELIVERY_METHOD) (channelId % net_constants::CHANNEL_TYPE_COUNT);
+    }
+
+    return (DELIVERY_METHOD) ((int32_t) DELIVERY_METHOD::UNRELIABLE + 1 +
+                              (UINT8_MAX - channelId) % net_constants::EXTENDED_CHANNEL_TYPE_COUNT);
 }
 
 lnl::net_base_channel* lnl::net_peer::create_channel(uint8_t idx) {
@@ -264,11 +601,18 @@ lnl::net_base_channel* lnl::net_peer::create_channel(uint8_t idx) {
     if (newChannel) {
         return newChannel;
     }
+
+    //ids between the basic and the extended channels in use
+    if (get_channel_number(idx) >= m_net_manager->channels_count) {
+        return nullptr;
+    }
     //InterlockedCompareExchangePointer()
 
-    switch ((DELIVERY_METHOD) (idx % net_constants::CHANNEL_TYPE_COUNT)) {
+    auto windowSize = m_extensions.window_size(get_channel_number(idx));
+
+    switch (get_channel_method(idx)) {
         case DELIVERY_METHOD::RELIABLE_UNORDERED: {
-            newChannel = new net_reliable_channel(this, false, idx);
+            newChannel = new net_reliable_channel(this, false, idx, windowSize);
             break;
         }
 
@@ -278,7 +622,7 @@ lnl::net_base_channel* lnl::net_peer::create_channel(uint8_t idx) {
         }
 
         case DELIVERY_METHOD::RELIABLE_ORDERED: {
-            newChannel = new net_reliable_channel(this, true, idx);
+            newChannel = new net_reliable_channel(this, true, idx, windowSize);
             break;
         }
 
@@ -286,8 +630,29 @@ lnl::net_base_channel* lnl::net_peer::create_channel(uint8_t idx) {
             newChannel = new net_sequenced_channel(this, true, idx);
             break;
         }
+
+        case DELIVERY_METHOD::REDUNDANT: {
+            newChannel = new net_redundant_channel(this, idx);
+            break;
+        }
+
+        case DELIVERY_METHOD::UNRELIABLE_NOTIFIED: {
+            newChannel = new net_notified_channel(this, idx, windowSize);
+            break;
+        }
+
+        case DELIVERY_METHOD::DELTA: {
+            newChannel = new net_delta_channel(this, idx, windowSize);
+            break;
+        }
+
+        default:
+            return nullptr;
     }
 
+    newChannel->m_priority = m_net_manager->get_channel_priority(get_channel_number(idx));
+    newChannel->m_weight = m_net_manager->get_channel_weight(get_channel_number(idx));
+
 #ifdef WIN32
     auto prevChannel = (net_base_channel*) InterlockedCompareExchangePointer((void**) &m_channels[idx], newChannel,
                                                                              nullptr);
@@ -305,8 +670,63 @@ lnl::net_base_channel* lnl::net_peer::create_channel(uint8_t idx) {
     return newChannel;
 }
 
+std::optional<lnl::net_congestion_state> lnl::net_peer::congestion_state() {
+    net_mutex_guard guard(m_congestion_mutex);
+
+    if (!m_congestion_controller) {
+        return {};
+    }
+
+    return m_congestion_controller->state();
+}
+
+bool lnl::net_peer::congestion_can_send(size_t bytes) {
+    net_mutex_guard guard(m_congestion_mutex);
+    return !m_congestion_controller || m_congestion_controller->can_send(bytes);
+}
+
+void lnl::net_peer::congestion_on_sent(size_t bytes, int64_t currentTime) {
+    net_mutex_guard guard(m_congestion_mutex);
+
+    if (m_congestion_controller) {
+        m_congestion_controller->on_packet_sent(bytes, currentTime);
+    }
+}
+
+void lnl::net_peer::congestion_on_acked(size_t bytes, int64_t rtt, int64_t currentTime) {
+    net_mutex_guard guard(m_congestion_mutex);
+
+    if (m_congestion_controller) {
+        m_congestion_controller->on_packet_acked(bytes, rtt, currentTime);
+    }
+}
+
+void lnl::net_peer::congestion_on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) {
+    net_mutex_guard guard(m_congestion_mutex);
+
+    if (m_congestion_controller) {
+        m_congestion_controller->on_packet_lost(bytes, sentTime, currentTime);
+    }
+}
+
+void lnl::net_peer::reset_mtu() {
+    net_mutex_guard guard(m_mtu_mutex);
+    set_mtu(0);
+    m_mtu_limit_idx = m_net_manager->mtu_count() - 1;
+    m_mtu_check_attempts = 0;
+    m_mtu_check_timer = MTU_CHECK_DELAY;
+    m_finish_mtu = false;
+}
+
+void lnl::net_peer::set_mtu(size_t mtuIdx) {
+    m_mtu_idx = mtuIdx;
+    m_mtu = net_constants::POSSIBLE_MTU[mtuIdx] - (int32_t) m_net_manager->packet_layer_size();
+}
+
 void lnl::net_peer::process_mtu_packet(lnl::net_packet* packet) {
-    if (packet->size() < net_constants::POSSIBLE_MTU[0]) {
+    auto layerSize = (int32_t) m_net_manager->packet_layer_size();
+
+    if ((int32_t) packet->size() + layerSize < net_constants::POSSIBLE_MTU[0]) {
         m_net_manager->pool_recycle(packet);
         return;
     }
@@ -314,37 +734,36 @@ void lnl::net_peer::process_mtu_packet(lnl::net_packet* packet) {
     auto receivedMtu = packet->get_value_at<int32_t>(1);
     auto endMtuCheck = packet->get_value_at<int32_t>(packet->size() - 4);
 
-    if (receivedMtu != packet->size() ||
+    if (receivedMtu != (int32_t) packet->size() + layerSize ||
         receivedMtu != endMtuCheck ||
-        receivedMtu > net_constants::MAX_PACKET_SIZE) {
+        receivedMtu > m_net_manager->max_packet_size()) {
         m_net_manager->pool_recycle(packet);
         return;
     }
 
     if (packet->property() == PACKET_PROPERTY::MTU_CHECK) {
-        m_mtu_check_attempts = 0;
         packet->set_property(PACKET_PROPERTY::MTU_OK);
-        m_net_manager->send_raw_and_recycle(packet, m_endpoint);
-        return;
-    }
-
-    if (receivedMtu <= m_mtu || m_finish_mtu) {
-        m_net_manager->pool_recycle(packet);
-        return;
-    }
-
-    if (receivedMtu != net_constants::POSSIBLE_MTU[m_mtu_idx + 1]) {
+        send_sealed(packet);
         m_net_manager->pool_recycle(packet);
         return;
     }
 
     {
+        //probes go out together, the largest candidate that made it wins whatever order they come back in
         net_mutex_guard guard(m_mtu_mutex);
-        set_mtu(m_mtu_idx + 1);
-    }
 
-    if (m_mtu_idx == net_constants::POSSIBLE_MTU.size() - 1) {
-        m_finish_mtu = true;
+        if (receivedMtu > net_constants::POSSIBLE_MTU[m_mtu_idx] && !m_finish_mtu) {
+            for (auto idx = m_mtu_idx + 1; idx <= m_mtu_limit_idx; ++idx) {
+                if (net_constants::POSSIBLE_MTU[idx] == receivedMtu) {
+                    set_mtu(idx);
+                    break;
+                }
+            }
+
+            if (m_mtu_idx == m_mtu_limit_idx) {
+                m_finish_mtu = true;
+            }
+        }
     }
 
     m_net_manager->pool_recycle(packet);
@@ -352,6 +771,11 @@ void lnl::net_peer::process_mtu_packet(lnl::net_packet* packet) {
 
 void lnl::net_peer::add_reliable_packet(lnl::DELIVERY_METHOD method, lnl::net_packet* packet) {
     if (!packet->is_fragmented()) {
+        if (m_extensions.has(PROTOCOL_FEATURE::RELIABLE_BUNDLE)) {
+            deliver_bundle(method, packet);
+            return;
+        }
+
         m_net_manager->create_receive_event(packet,
                                             method,
                                             (uint8_t) (packet->channel_id() / net_constants::CHANNEL_TYPE_COUNT),
@@ -427,6 +851,44 @@ void lnl::net_peer::add_reliable_packet(lnl::DELIVERY_METHOD method, lnl::net_pa
                                         0, m_endpoint);
 }
 
+void lnl::net_peer::deliver_bundle(lnl::DELIVERY_METHOD method, lnl::net_packet* packet) {
+    auto channelNumber = (uint8_t) (packet->channel_id() / net_constants::CHANNEL_TYPE_COUNT);
+    size_t pos = net_constants::CHANNELED_HEADER_SIZE;
+    size_t lastPos = 0;
+
+    //records are checked before any of them is delivered
+    while (pos < packet->size()) {
+        if (pos + net_constants::RECORD_HEADER_SIZE > packet->size()) {
+            m_net_manager->pool_recycle(packet);
+            return;
+        }
+
+        lastPos = pos;
+        pos += net_constants::RECORD_HEADER_SIZE + packet->get_value_at<uint16_t>(pos);
+    }
+
+    if (pos != packet->size() || lastPos == 0) {
+        m_net_manager->pool_recycle(packet);
+        return;
+    }
+
+    for (pos = net_constants::CHANNELED_HEADER_SIZE; pos < lastPos;) {
+        auto size = packet->get_value_at<uint16_t>(pos);
+        auto message = m_net_manager->pool_get_packet(net_constants::CHANNELED_HEADER_SIZE + size);
+        message->set_property(PACKET_PROPERTY::CHANNELED);
+        message->copy_from(packet->data(), pos + net_constants::RECORD_HEADER_SIZE,
+                           net_constants::CHANNELED_HEADER_SIZE, size);
+
+        m_net_manager->create_receive_event(message, method, channelNumber, net_constants::CHANNELED_HEADER_SIZE,
+                                            m_endpoint);
+        pos += net_constants::RECORD_HEADER_SIZE + size;
+    }
+
+    //the last record reaches the end of the packet and is read in place
+    m_net_manager->create_receive_event(packet, method, channelNumber, lastPos + net_constants::RECORD_HEADER_SIZE,
+                                        m_endpoint);
+}
+
 void lnl::net_peer::clear_holded_fragments(uint16_t fragmentId) {
     auto it = m_holded_fragments.find(fragmentId);
 
@@ -446,45 +908,523 @@ void lnl::net_peer::clear_holded_fragments(uint16_t fragmentId) {
 void lnl::net_peer::send_user_data(lnl::net_packet* packet) {
     static const size_t sizeTreshold = 20;
     packet->set_connection_number(m_connect_number);
+
+    if (m_sending_channel) {
+        m_sending_channel->m_deficit -= (int64_t) packet->size();
+    }
+
+    if (is_fec_protected(packet)) {
+        send_fec_protected(packet);
+        return;
+    }
     auto mergedPacketSize = net_constants::HEADER_SIZE + packet->size() + 2;
 
     if (mergedPacketSize + sizeTreshold >= m_mtu) {
-        m_net_manager->send_raw(packet, m_endpoint);
+        send_datagram(packet->data(), 0, packet->size());
         return;
     }
 
-    if (m_merge_pos + mergedPacketSize > m_mtu) {
+    //the queued ack of the same channel rides along when there is room
+    auto ackChannel = get_piggyback_channel(packet);
+    size_t ackSize = ackChannel ? ackChannel->ack_size() + 2 : 0;
+
+    if (mergedPacketSize + ackSize + sizeTreshold >= m_mtu) {
+        ackChannel = nullptr;
+        ackSize = 0;
+    }
+
+    if (m_merge_pos + mergedPacketSize + ackSize > m_mtu) {
         send_merged();
     }
 
-    m_merge_data.set_value_at((uint16_t) packet->size(), m_merge_pos + net_constants::HEADER_SIZE);
-    m_merge_data.copy_from(packet->data(), 0, m_merge_pos + net_constants::HEADER_SIZE + 2, packet->size());
-    m_merge_pos += packet->size() + 2;
+    auto pos = m_merge_pos + net_constants::HEADER_SIZE + 2;
+    m_merge_data.copy_from(packet->data(), 0, pos, packet->size());
+
+    if (ackChannel) {
+        auto recordPos = pos + packet->size();
+        auto recordSize = ackChannel->write_ack(&m_merge_data.data()[recordPos], ackSize - 2);
+
+        if (recordSize > 0) {
+            m_merge_data.set_value_at((uint16_t) recordSize, recordPos + recordSize);
+            m_merge_data.data()[pos] = (uint8_t) ((m_merge_data.data()[pos] & 0xE0) |
+                                                  (uint8_t) PACKET_PROPERTY::CHANNELED_ACK);
+            ackSize = recordSize + 2;
+            dequeue_ack(ackChannel);
+        } else {
+            ackSize = 0;
+        }
+    }
+
+    m_merge_data.set_value_at((uint16_t) (packet->size() + ackSize), m_merge_pos + net_constants::HEADER_SIZE);
+    m_merge_pos += packet->size() + ackSize + 2;
     m_merge_count++;
 }
 
-void lnl::net_peer::send_merged() {
-    if (m_merge_count == 0) {
-        return;
+bool lnl::net_peer::is_fec_protected(const lnl::net_packet* packet) const {
+    if (!m_extensions.has(PROTOCOL_FEATURE::FEC) ||
+        packet->size() + net_constants::FEC_REPAIR_HEADER_SIZE > (size_t) m_mtu) {
+        return false;
+    }
+
+    switch (packet->property()) {
+        case PACKET_PROPERTY::UNRELIABLE:
+            return true;
+
+        case PACKET_PROPERTY::CHANNELED:
+            return get_channel_method(packet->channel_id()) == DELIVERY_METHOD::SEQUENCED;
+
+        default:
+            return false;
+    }
+}
+
+void lnl::net_peer::send_fec_protected(lnl::net_packet* packet) {
+    auto groupSize = std::clamp<int32_t>(m_net_manager->fec_group_size, 2, net_constants::MAX_FEC_GROUP_SIZE);
+
+    //members of a group are never merged, one lost datagram must not take several of them
+    m_fec_encoder.wrap(packet, &m_fec_packet);
+    m_fec_packet.set_connection_number(m_connect_number);
+    send_datagram(m_fec_packet.data(), 0, m_fec_packet.size());
+
+    if (m_fec_encoder.count() < groupSize) {
+        return;
     }
 
+    m_fec_encoder.write_repair(&m_fec_packet);
+    m_fec_packet.set_connection_number(m_connect_number);
+    send_datagram(m_fec_packet.data(), 0, m_fec_packet.size());
+}
+
+lnl::net_base_channel* lnl::net_peer::get_piggyback_channel(const lnl::net_packet* packet) const {
+    if (packet->property() != PACKET_PROPERTY::CHANNELED ||
+        !m_extensions.has(PROTOCOL_FEATURE::PIGGYBACK_ACK) ||
+        packet->channel_id() >= m_channels.size()) {
+        return nullptr;
+    }
+
+    auto channel = m_channels[packet->channel_id()];
+    return channel && channel->m_ack_queued ? channel : nullptr;
+}
+
+void lnl::net_peer::send_merged() {
+    if (m_merge_count == 0) {
+        return;
+    }
+
+    const net_packet* packet = &m_merge_data;
     size_t offset = 0;
     size_t size = 0;
 
-    if (m_merge_count > 1) {
+    if (m_merge_count > 1 && m_extensions.has(PROTOCOL_FEATURE::COMPACT_HEADER)) {
+        //packed headers grow past the mtu only in rare cases, those packets stay MERGED
+        size = net_compact_writer::write(&m_merge_data, net_constants::HEADER_SIZE + m_merge_pos,
+                                         &m_compact_data, m_mtu);
+        packet = &m_compact_data;
+    }
+
+    if (size > 0) {
+        m_compact_data.set_connection_number(m_connect_number);
+    } else if (m_merge_count > 1) {
+        packet = &m_merge_data;
         offset = 0;
         size = net_constants::HEADER_SIZE + m_merge_pos;
     } else {
+        packet = &m_merge_data;
         offset = net_constants::HEADER_SIZE + 2;
         size = m_merge_pos - 2;
     }
 
-    m_net_manager->send_raw(m_merge_data.data(), offset, size, m_endpoint);
+    send_datagram(packet->data(), offset, size);
 
     m_merge_pos = 0;
     m_merge_count = 0;
 }
 
+void lnl::net_peer::queue_ack(lnl::net_base_channel* channel) {
+    if (channel->m_ack_queued) {
+        return;
+    }
+
+    channel->m_ack_queued = true;
+    m_ack_channels.push_back(channel);
+
+    if (m_ack_channels.size() > 1) {
+        return;
+    }
+
+    auto delay = m_net_manager->ack_delay;
+    m_ack_deadline = get_current_time() + (int64_t) delay * TICKS_PER_MILLISECOND;
+
+    if (delay > 0) {
+        m_net_manager->schedule_logic_wakeup(net_signal::clock::now() + std::chrono::milliseconds(delay));
+    }
+}
+
+void lnl::net_peer::dequeue_ack(lnl::net_base_channel* channel) {
+    channel->m_ack_queued = false;
+    m_ack_channels.erase(std::find(m_ack_channels.begin(), m_ack_channels.end(), channel));
+}
+
+void lnl::net_peer::send_queued_acks(int64_t currentTime) {
+    if (m_ack_channels.empty() || currentTime < m_ack_deadline) {
+        return;
+    }
+
+    if (!m_extensions.has(PROTOCOL_FEATURE::COMPOUND_ACK)) {
+        //no outgoing data picked these up, send them as plain acks
+        m_ack_buffer.set_property(PACKET_PROPERTY::ACK);
+
+        for (auto channel: m_ack_channels) {
+            channel->m_ack_queued = false;
+
+            auto size = channel->write_ack(&m_ack_buffer.data()[net_constants::HEADER_SIZE],
+                                           m_ack_buffer.buffer_size() - net_constants::HEADER_SIZE);
+
+            if (size > 0) {
+                m_ack_buffer.resize(net_constants::HEADER_SIZE + size);
+                send_user_data(&m_ack_buffer);
+            }
+        }
+
+        m_ack_channels.clear();
+        return;
+    }
+
+    m_ack_buffer.set_property(PACKET_PROPERTY::COMPOUND_ACK);
+    size_t pos = net_constants::HEADER_SIZE;
+
+    for (auto channel: m_ack_channels) {
+        channel->m_ack_queued = false;
+
+        auto capacity = (size_t) m_mtu > pos + 2 ? m_mtu - pos - 2 : 0;
+        auto size = channel->write_ack(&m_ack_buffer.data()[pos + 2], capacity);
+
+        if (size == 0 && pos > net_constants::HEADER_SIZE) {
+            //full, send what we have and start over
+            m_ack_buffer.resize(pos);
+            send_user_data(&m_ack_buffer);
+
+            pos = net_constants::HEADER_SIZE;
+            size = channel->write_ack(&m_ack_buffer.data()[pos + 2], m_mtu - pos - 2);
+        }
+
+        if (size == 0) {
+            continue;
+        }
+
+        m_ack_buffer.set_value_at((uint16_t) size, pos);
+        pos += 2 + size;
+    }
+
+    m_ack_channels.clear();
+
+    if (pos > net_constants::HEADER_SIZE) {
+        m_ack_buffer.resize(pos);
+        send_user_data(&m_ack_buffer);
+    }
+}
+
+void lnl::net_peer::send_datagram(const uint8_t* data, size_t offset, size_t size) {
+    if (m_extensions.has(PROTOCOL_FEATURE::COMPRESSION)) {
+        auto compressedSize = compress_datagram(&data[offset], size);
+
+        if (compressedSize > 0) {
+            data = m_compression_buffer.data();
+            offset = 0;
+            size = compressedSize;
+        }
+    }
+
+    if (m_seal_cipher && is_sealed((PACKET_PROPERTY) (data[offset] & 0x1F))) {
+        size = seal_datagram(&data[offset], size, m_seal_buffer.data());
+        data = m_seal_buffer.data();
+        offset = 0;
+    }
+
+    m_egress_credit -= (double) size;
+
+    if (!m_pacer.enabled()) {
+        m_net_manager->send_raw(data, offset, size, m_endpoint);
+        return;
+    }
+
+    auto currentTime = get_current_time();
+
+    if (m_paced_queue.empty() && m_pacer.try_consume(size, currentTime)) {
+        m_net_manager->send_raw(data, offset, size, m_endpoint);
+        return;
+    }
+
+    //the send pass stops while datagrams wait, so only acks and what one pass produced get here, the rest
+    //is dropped like on a full link, reliable packets are resent
+    if (m_paced_queue.size() >= MAX_PACED_QUEUE_SIZE) {
+        return;
+    }
+
+    auto packet = m_net_manager->pool_get_packet(size);
+    packet->copy_from(data, offset, 0, size);
+    m_paced_queue.push(packet);
+
+    if (m_paced_queue.size() == 1) {
+        schedule_pacing_wakeup(size);
+    }
+}
+
+bool lnl::net_peer::is_sealed(lnl::PACKET_PROPERTY property) {
+    switch (property) {
+        case PACKET_PROPERTY::CONNECT_REQUEST:
+        case PACKET_PROPERTY::CONNECT_ACCEPT:
+        case PACKET_PROPERTY::CONNECT_CHALLENGE:
+        case PACKET_PROPERTY::UNCONNECTED_MESSAGE:
+        case PACKET_PROPERTY::BROADCAST:
+        case PACKET_PROPERTY::SHUTDOWN_OK:
+        case PACKET_PROPERTY::PEER_NOT_FOUND:
+        case PACKET_PROPERTY::INVALID_PROTOCOL:
+        case PACKET_PROPERTY::NAT_MESSAGE:
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+void lnl::net_peer::init_encryption(uint64_t requestSalt, uint64_t acceptSalt, bool accepting) {
+    uint8_t salt[net_chacha20_poly1305::SALT_SIZE];
+    memcpy(&salt[0], &requestSalt, sizeof(requestSalt));
+    memcpy(&salt[sizeof(requestSalt)], &acceptSalt, sizeof(acceptSalt));
+
+    uint8_t key[net_chacha20_poly1305::KEY_SIZE];
+    net_chacha20_poly1305::derive_key(m_net_manager->encryption_key.data(), salt, key);
+
+    m_seal_cipher = std::make_unique<net_chacha20_poly1305>(key, accepting ? 1 : 0);
+    m_open_cipher = std::make_unique<net_chacha20_poly1305>(key, accepting ? 0 : 1);
+}
+
+size_t lnl::net_peer::seal_datagram(const uint8_t* data, size_t size, uint8_t* dst) {
+    auto nonce = m_seal_nonce++;
+    memcpy(dst, data, size);
+
+    //the first byte stays readable so the receiver knows whether to open it, the tag covers it
+    net_aead_job job;
+    job.cipher = m_seal_cipher.get();
+    job.nonce = nonce;
+    job.ad = dst;
+    job.ad_size = net_constants::HEADER_SIZE;
+    job.data = &dst[net_constants::HEADER_SIZE];
+    job.size = size - net_constants::HEADER_SIZE;
+    job.tag = &dst[size];
+    net_chacha20_poly1305::seal_batch(&job, 1);
+
+    *(uint32_t*) &dst[size + net_chacha20_poly1305::TAG_SIZE] = (uint32_t) nonce;
+
+    return size + net_constants::ENCRYPTION_TRAILER_SIZE;
+}
+
+int32_t lnl::net_peer::send_sealed(const uint8_t* data, size_t offset, size_t size) {
+    if (!m_seal_cipher || !is_sealed((PACKET_PROPERTY) (data[offset] & 0x1F))) {
+        return m_net_manager->send_raw(data, offset, size, m_endpoint);
+    }
+
+    auto packet = m_net_manager->pool_get_packet(size + net_constants::ENCRYPTION_TRAILER_SIZE);
+    seal_datagram(&data[offset], size, packet->data());
+    return m_net_manager->send_raw_and_recycle(packet, m_endpoint);
+}
+
+bool lnl::net_peer::make_open_job(lnl::net_packet* packet, lnl::net_aead_job& job) {
+    if (!m_open_cipher || packet->size() < net_constants::HEADER_SIZE + net_constants::ENCRYPTION_TRAILER_SIZE) {
+        return false;
+    }
+
+    auto size = packet->size() - net_constants::ENCRYPTION_TRAILER_SIZE;
+    auto truncated = packet->get_value_at<uint32_t>(size + net_chacha20_poly1305::TAG_SIZE);
+
+    //the full nonce closest to the next expected one
+    constexpr uint64_t NONCE_WINDOW = 1ull << 32;
+    auto nonce = (m_open_nonce_next & ~(NONCE_WINDOW - 1)) | truncated;
+
+    if (nonce + NONCE_WINDOW / 2 <= m_open_nonce_next) {
+        nonce += NONCE_WINDOW;
+    } else if (nonce > m_open_nonce_next + NONCE_WINDOW / 2 && nonce >= NONCE_WINDOW) {
+        nonce -= NONCE_WINDOW;
+    }
+
+    job.cipher = m_open_cipher.get();
+    job.nonce = nonce;
+    job.ad = packet->data();
+    job.ad_size = net_constants::HEADER_SIZE;
+    job.data = &packet->data()[net_constants::HEADER_SIZE];
+    job.size = size - net_constants::HEADER_SIZE;
+    job.tag = &packet->data()[size];
+    job.valid = false;
+
+    return true;
+}
+
+bool lnl::net_peer::accept_nonce(uint64_t nonce) {
+    if (nonce >= m_open_nonce_next) {
+        auto shift = nonce - m_open_nonce_next + 1;
+        m_open_window = shift >= 64 ? 0 : m_open_window << shift;
+        m_open_window |= 1;
+        m_open_nonce_next = nonce + 1;
+        return true;
+    }
+
+    auto age = m_open_nonce_next - 1 - nonce;
+
+    if (age >= 64 || (m_open_window & (1ull << age)) != 0) {
+        return false;
+    }
+
+    m_open_window |= 1ull << age;
+    return true;
+}
+
+size_t lnl::net_peer::compress_datagram(const uint8_t* data, size_t size) {
+    size_t compressedSize = 0;
+    int64_t elapsed = 0;
+
+    if (m_compression_skip > 0) {
+        m_compression_skip--;
+    } else if (size >= m_net_manager->compression_min_size) {
+        auto dictionaryChannel = get_dictionary_channel(data, size);
+        auto dictionary = dictionaryChannel >= 0 ? m_net_manager->get_channel_dictionary(dictionaryChannel) : nullptr;
+
+        m_compression_buffer[0] = (uint8_t) PACKET_PROPERTY::COMPRESSED | (uint8_t) (m_connect_number << 5);
+        m_compression_buffer[1] = dictionary ? (uint8_t) (dictionaryChannel + 1) : 0;
+        size_t headerSize = net_constants::HEADER_SIZE + 1;
+        write_varint(m_compression_buffer.data(), m_compression_buffer.size(), headerSize, size);
+
+        //must save at least a sixteenth to be worth the decompression
+        auto capacity = size - size / 16;
+
+        if (capacity > headerSize) {
+            auto start = std::chrono::steady_clock::now();
+            compressedSize = m_compressor.compress(data, size, &m_compression_buffer[headerSize],
+                                                   capacity - headerSize, dictionary);
+            elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+        }
+
+        if (compressedSize > 0) {
+            compressedSize += headerSize;
+            m_compression_backoff = 0;
+        } else {
+            //incompressible traffic tends to stay that way, try again after a growing number of datagrams
+            m_compression_backoff = std::clamp<uint32_t>(m_compression_backoff * 2, 1, MAX_COMPRESSION_BACKOFF);
+            m_compression_skip = m_compression_backoff;
+        }
+    }
+
+    net_mutex_guard guard(m_compression_stats_mutex);
+    m_compression_stats.input_bytes += size;
+    m_compression_stats.output_bytes += compressedSize > 0 ? compressedSize : size;
+    m_compression_stats.compress_time += elapsed;
+
+    if (compressedSize > 0) {
+        m_compression_stats.compressed_packets++;
+    } else {
+        m_compression_stats.uncompressed_packets++;
+    }
+
+    return compressedSize;
+}
+
+int32_t lnl::net_peer::get_dictionary_channel(const uint8_t* data, size_t size) const {
+    size_t pos = 0;
+    auto property = (PACKET_PROPERTY) (data[0] & 0x1F);
+
+    if (property == PACKET_PROPERTY::MERGED) {
+        pos = net_constants::HEADER_SIZE + 2;
+
+        if (size <= pos) {
+            return -1;
+        }
+
+        property = (PACKET_PROPERTY) (data[pos] & 0x1F);
+    }
+
+    if ((property != PACKET_PROPERTY::CHANNELED && property != PACKET_PROPERTY::CHANNELED_ACK) ||
+        size < pos + net_constants::CHANNELED_HEADER_SIZE ||
+        data[pos + 3] >= m_channels.size()) {
+        return -1;
+    }
+
+    return get_channel_number(data[pos + 3]);
+}
+
+lnl::net_compression_stats lnl::net_peer::compression_stats() {
+    net_mutex_guard guard(m_compression_stats_mutex);
+    return m_compression_stats;
+}
+
+void lnl::net_peer::schedule_pacing_wakeup(size_t bytes) {
+    schedule_wakeup(m_pacer.delay_for(bytes));
+}
+
+void lnl::net_peer::schedule_wakeup(int64_t delay) {
+    m_net_manager->schedule_logic_wakeup(net_signal::clock::now() +
+                                         std::chrono::microseconds(delay * 1000 / TICKS_PER_MILLISECOND));
+}
+
+bool lnl::net_peer::has_egress_credit() const {
+    return m_net_manager->max_egress_rate <= 0. || m_egress_credit > 0.;
+}
+
+bool lnl::net_peer::has_send_room() const {
+    return has_egress_credit() && m_paced_queue.empty();
+}
+
+void lnl::net_peer::add_egress_credit(double credit, double maxCredit) {
+    net_mutex_guard guard(m_send_mutex);
+    m_egress_credit = std::min(m_egress_credit + credit, maxCredit);
+}
+
+double lnl::net_peer::take_unused_egress_credit(double reserve) {
+    net_mutex_guard guard(m_send_mutex);
+
+    if (m_egress_credit <= reserve) {
+        return 0.;
+    }
+
+    auto unused = m_egress_credit - reserve;
+    m_egress_credit = reserve;
+
+    return unused;
+}
+
+void lnl::net_peer::update_pacing_rate() {
+    if (!m_net_manager->pacing_enabled) {
+        m_pacer.set_rate(0., 0);
+        return;
+    }
+
+    auto rate = m_net_manager->pacing_rate;
+
+    if (rate <= 0.) {
+        net_mutex_guard guard(m_congestion_mutex);
+
+        if (m_congestion_controller) {
+            rate = m_congestion_controller->pacing_rate();
+        }
+    }
+
+    m_pacer.set_rate(rate, m_net_manager->pacing_burst);
+}
+
+void lnl::net_peer::send_paced(int64_t currentTime) {
+    while (!m_paced_queue.empty()) {
+        auto packet = m_paced_queue.front();
+
+        if (m_pacer.enabled() && !m_pacer.try_consume(packet->size(), currentTime)) {
+            schedule_pacing_wakeup(packet->size());
+            return;
+        }
+
+        m_paced_queue.pop();
+        m_net_manager->send_raw_and_recycle(packet, m_endpoint);
+    }
+}
+
 void lnl::net_peer::recycle_and_deliver(lnl::net_packet* packet) {
     if (packet->user_data == nullptr) {
         m_net_manager->pool_recycle(packet);
@@ -492,6 +1432,7 @@ void lnl::net_peer::recycle_and_deliver(lnl::net_packet* packet) {
     }
 
     if (packet->is_fragmented()) {
+        net_mutex_guard guard(m_delivered_fragments_mutex);
         auto it = m_delivered_fragments.find(packet->fragment_id());
 
         if (it != m_delivered_fragments.end()) {
@@ -531,7 +1472,7 @@ void lnl::net_peer::update(int32_t deltaTime) {
 
                 if (m_shutdown_timer >= SHUTDOWN_DELAY) {
                     m_shutdown_timer = 0;
-                    m_net_manager->send_raw(&m_shutdown_packet, m_endpoint);
+                    send_sealed(&m_shutdown_packet);
                 }
             }
 
@@ -567,51 +1508,115 @@ void lnl::net_peer::update(int32_t deltaTime) {
     if (m_ping_send_timer >= m_net_manager->ping_interval) {
         m_ping_send_timer = 0;
         m_ping_packet.set_sequence(m_ping_packet.sequence() + 1);
-
-        if (m_ping_timer.running()) {
-            update_roundtrip_time((int32_t) m_ping_timer.milliseconds());
-        }
+        //an unanswered ping is not an rtt sample, a late pong is ignored by its sequence
         m_ping_timer.restart();
-        m_net_manager->send_raw(&m_ping_packet, m_endpoint);
+        send_sealed(&m_ping_packet);
     }
 
-    //RTT
-    m_rtt_reset_timer += deltaTime;
+    update_mtu_logic(deltaTime);
+
+    process_send_queues();
+}
 
-    if (m_rtt_reset_timer > m_net_manager->ping_interval * 3) {
-        m_rtt_reset_timer = 0;
-        m_rtt = m_avg_rtt;
-        m_rtt_count = 1;
+void lnl::net_peer::flush() {
+    if (m_connection_state != CONNECTION_STATE::CONNECTED) {
+        return;
     }
 
-    update_mtu_logic(deltaTime);
+    process_send_queues();
+}
 
-    auto count = m_channel_send_queue.size();
+void lnl::net_peer::process_send_queues() {
+    net_mutex_guard guard(m_send_mutex);
 
-    while (count-- > 0) {
-        auto channel = m_channel_send_queue.dequeue();
+    update_pacing_rate();
+    send_paced(get_current_time());
 
-        if (!channel) {
-            break;
+    m_egress_blocked = false;
+
+    std::optional<net_base_channel*> queued;
+
+    while ((queued = m_channel_send_queue.dequeue())) {
+        m_scheduled_channels[queued.value()->m_priority].push_back(queued.value());
+    }
+
+    //unreliable state updates get a quantum ahead of the reliable backlog, so a short budget can't starve them
+    send_unreliable(m_mtu);
+
+    for (auto level = m_scheduled_channels.rbegin(); level != m_scheduled_channels.rend() && !m_egress_blocked;
+         ++level) {
+        send_scheduled(*level);
+    }
+
+    if (!m_egress_blocked) {
+        send_unreliable(SIZE_MAX);
+    }
+
+    send_queued_acks(get_current_time());
+    send_merged();
+}
+
+void lnl::net_peer::send_scheduled(std::deque<net_base_channel*>& channels) {
+    auto visits = channels.size();
+
+    while (visits-- > 0) {
+        if (!has_send_room()) {
+            //the rest waits for the next share of the manager budget or for the pacer
+            m_egress_blocked = !has_egress_credit();
+            return;
         }
 
-        if (channel.value()->send_and_check_queue()) {
-            m_channel_send_queue.push(*channel);
+        auto channel = channels.front();
+        channels.pop_front();
+
+        //a channel cut off by the egress budget or the pacer finishes its quantum before it gets a new one
+        if (channel->m_deficit <= 0) {
+            channel->m_deficit += (int64_t) channel->m_weight * m_mtu;
         }
-    }
+        m_sending_channel = channel;
+        auto hasPacketsToSend = channel->send_and_check_queue();
+        m_sending_channel = nullptr;
 
-    {
-        net_mutex_guard guard(m_unreliable_channel_mutex);
+        if (!hasPacketsToSend) {
+            channel->m_deficit = 0;
+            continue;
+        }
 
-        while (!m_unreliable_channel.empty()) {
-            auto packet = m_unreliable_channel.front();
-            m_unreliable_channel.pop();
-            send_user_data(packet);
-            m_net_manager->pool_recycle(packet);
+        if (!has_send_room()) {
+            //cut off by the egress budget or the pacer, resumes first with the rest of its quantum
+            channels.push_front(channel);
+            m_egress_blocked = !has_egress_credit();
+            return;
+        }
+
+        channels.push_back(channel);
+
+        if (channel->m_deficit <= 0) {
+            //used up its quantum, gets another round in this pass
+            visits++;
+        } else {
+            //waits for acks or timers, unused quanta are not saved up
+            channel->m_deficit = 0;
         }
     }
+}
 
-    send_merged();
+void lnl::net_peer::send_unreliable(size_t quota) {
+    net_mutex_guard guard(m_unreliable_channel_mutex);
+    size_t sent = 0;
+
+    while (!m_unreliable_channel.empty() && sent < quota) {
+        if (!has_send_room()) {
+            m_egress_blocked = !has_egress_credit();
+            return;
+        }
+
+        auto packet = m_unreliable_channel.front();
+        m_unreliable_channel.pop();
+        sent += packet->size();
+        send_user_data(packet);
+        m_net_manager->pool_recycle(packet);
+    }
 }
 
 lnl::CONNECT_REQUEST_RESULT lnl::net_peer::process_connect_request(
@@ -666,40 +1671,95 @@ void lnl::net_peer::update_mtu_logic(int32_t deltaTime) {
         return;
     }
 
+    //the first round goes out right after connect, the next ones once the previous probes had time to return
     m_mtu_check_timer += deltaTime;
 
-    if (m_mtu_check_timer < MTU_CHECK_DELAY) {
+    if (m_mtu_check_timer < std::clamp((int32_t) m_resend_delay, MIN_MTU_CHECK_DELAY, MTU_CHECK_DELAY)) {
         return;
     }
 
     m_mtu_check_timer = 0;
+
+    net_mutex_guard guard(m_mtu_mutex);
+
+    if (m_mtu_check_attempts >= MAX_MTU_CHECK_ATTEMPTS || m_mtu_idx >= m_mtu_limit_idx) {
+        m_finish_mtu = true;
+        return;
+    }
+
     m_mtu_check_attempts++;
 
-    if (m_mtu_check_attempts >= MAX_MTU_CHECK_ATTEMPTS) {
+    for (auto idx = m_mtu_idx + 1; idx <= m_mtu_limit_idx; ++idx) {
+        auto newMtu = net_constants::POSSIBLE_MTU[idx];
+        //probes fill the candidate datagram together with the packet layers
+        auto packet = m_net_manager->pool_get_packet(newMtu - m_net_manager->packet_layer_size());
+        packet->set_property(PACKET_PROPERTY::MTU_CHECK);
+        packet->set_value_at(newMtu, 1);
+        packet->set_value_at(newMtu, packet->size() - 4);
+
+        auto result = send_sealed(packet);
+        m_net_manager->pool_recycle(packet);
+
+        //with IP_PMTUDISC_PROBE the kernel only refuses sends above the interface mtu, so larger ones fail too,
+        //other errors may be transient and don't limit the mtu
+        if (result == net_manager::SEND_RESULT_TOO_LARGE) {
+            m_mtu_limit_idx = idx - 1;
+            break;
+        }
+    }
+
+    if (m_mtu_idx >= m_mtu_limit_idx) {
         m_finish_mtu = true;
+    }
+}
+
+void lnl::net_peer::send_with_delivery_event(const uint8_t* data, size_t offset, size_t size, uint8_t channelNumber,
+                                             lnl::DELIVERY_METHOD deliveryMethod, void* userData) {
+    if (deliveryMethod != DELIVERY_METHOD::RELIABLE_ORDERED &&
+        deliveryMethod != DELIVERY_METHOD::RELIABLE_UNORDERED &&
+        deliveryMethod != DELIVERY_METHOD::UNRELIABLE_NOTIFIED) {
+        m_net_manager->create_error_event(0, "Delivery event works only for ReliableOrdered, ReliableUnordered "
+                                             "and UnreliableNotified delivery methods");
         return;
     }
 
-    net_mutex_guard guard(m_mtu_mutex);
+    send_internal(data, offset, size, channelNumber, deliveryMethod, userData, false);
+}
 
-    if (m_mtu_idx >= net_constants::POSSIBLE_MTU.size() - 1) {
+void lnl::net_peer::send_delta(const uint8_t* data, size_t offset, size_t size, uint16_t key, uint8_t channelNumber) {
+    if (m_connection_state != CONNECTION_STATE::CONNECTED || channelNumber >= m_net_manager->channels_count) {
         return;
     }
 
-    auto newMtu = net_constants::POSSIBLE_MTU[m_mtu_idx + 1];
-    auto packet = m_net_manager->pool_get_packet(newMtu);
-    packet->set_property(PACKET_PROPERTY::MTU_CHECK);
-    packet->set_value_at(newMtu, 1);
-    packet->set_value_at(newMtu, packet->size() - 4);
+    auto channelId = get_channel_id(channelNumber, DELIVERY_METHOD::DELTA);
 
-    if (m_net_manager->send_raw_and_recycle(packet, m_endpoint) <= 0) {
-        m_finish_mtu = true;
+    if (channelId < 0) {
+        m_net_manager->create_error_event(0, string_format("Channel %i has no delta channel id left, "
+                                                           "see EXTENDED_CHANNEL_TYPE_COUNT", channelNumber));
+        return;
     }
+
+    auto maxSize = m_mtu - net_constants::CHANNELED_HEADER_SIZE - net_constants::DELTA_HEADER_SIZE;
+
+    if (size > maxSize) {
+        m_net_manager->create_error_event(0,
+                                          string_format(
+                                                  "Delta snapshot size exceeded maximum of %i bytes",
+                                                  maxSize));
+        return;
+    }
+
+    static_cast<net_delta_channel*>(create_channel((uint8_t) channelId))->send(data, offset, size, key);
 }
 
 void lnl::net_peer::send_internal(const uint8_t* data, size_t offset, size_t size, uint8_t channelNumber,
-                                  lnl::DELIVERY_METHOD deliveryMethod, void* userData) {
-    if (m_connection_state != CONNECTION_STATE::CONNECTED || channelNumber >= m_channels.size()) {
+                                  lnl::DELIVERY_METHOD deliveryMethod, void* userData, bool immediate) {
+    if (m_connection_state != CONNECTION_STATE::CONNECTED || channelNumber >= m_net_manager->channels_count) {
+        return;
+    }
+
+    if (deliveryMethod == DELIVERY_METHOD::DELTA) {
+        m_net_manager->create_error_event(0, "Delta snapshots are sent with send_delta");
         return;
     }
 
@@ -709,21 +1769,42 @@ void lnl::net_peer::send_internal(const uint8_t* data, size_t offset, size_t siz
     if (deliveryMethod == DELIVERY_METHOD::UNRELIABLE) {
         property = PACKET_PROPERTY::UNRELIABLE;
     } else {
+        auto channelId = get_channel_id(channelNumber, deliveryMethod);
+
+        if (channelId < 0) {
+            m_net_manager->create_error_event(0, string_format("Channel %i has no channel id left for delivery "
+                                                               "method %i, see EXTENDED_CHANNEL_TYPE_COUNT",
+                                                               channelNumber, (int32_t) deliveryMethod));
+            return;
+        }
+
         property = PACKET_PROPERTY::CHANNELED;
-        channel = create_channel(
-                (uint8_t) (channelNumber * net_constants::CHANNEL_TYPE_COUNT + (uint8_t) deliveryMethod));
+        channel = create_channel((uint8_t) channelId);
+
+        if (!channel) {
+            return;
+        }
     }
 
     auto headerSize = net_packet::get_header_size(property);
+    auto isFragmentable = deliveryMethod == DELIVERY_METHOD::RELIABLE_ORDERED ||
+                          deliveryMethod == DELIVERY_METHOD::RELIABLE_UNORDERED;
+    size_t recordHeaderSize = 0;
+
+    //messages of REDUNDANT and bundled reliable packets carry their size in front of them, fragments don't
+    if (deliveryMethod == DELIVERY_METHOD::REDUNDANT ||
+        (isFragmentable && m_extensions.has(PROTOCOL_FEATURE::RELIABLE_BUNDLE))) {
+        recordHeaderSize = net_constants::RECORD_HEADER_SIZE;
+    }
+
     auto mtu = m_mtu;
 
-    if (size + headerSize > mtu) {
-        if (deliveryMethod != DELIVERY_METHOD::RELIABLE_ORDERED &&
-            deliveryMethod != DELIVERY_METHOD::RELIABLE_UNORDERED) {
+    if (size + headerSize + recordHeaderSize > mtu) {
+        if (!isFragmentable) {
             m_net_manager->create_error_event(0,
                                               string_format(
                                                       "Unreliable or ReliableSequenced packet size exceeded maximum of %i bytes, Check allowed size by get_max_single_packet_size",
-                                                      mtu - headerSize));
+                                                      mtu - headerSize - recordHeaderSize));
             return;
         }
 
@@ -744,6 +1825,11 @@ void lnl::net_peer::send_internal(const uint8_t* data, size_t offset, size_t siz
         auto currentFragmentId = (uint16_t) __sync_add_and_fetch((uint32_t*) &m_fragment_id, 1);
 #endif
 
+        if (userData) {
+            net_mutex_guard guard(m_delivered_fragments_mutex);
+            m_delivered_fragments[currentFragmentId] = 0;
+        }
+
         for (uint16_t partIdx = 0; partIdx < totalPackets; partIdx++) {
             auto sendLength = size > packetDataSize ? packetDataSize : size;
 
@@ -764,18 +1850,39 @@ void lnl::net_peer::send_internal(const uint8_t* data, size_t offset, size_t siz
             size -= sendLength;
         }
 
+        if (immediate) {
+            flush();
+        }
+
         return;
     }
 
-    auto packet = m_net_manager->pool_get_packet(headerSize + size);
+    auto packet = m_net_manager->pool_get_packet(headerSize + recordHeaderSize + size);
     packet->set_property(property);
     packet->user_data = userData;
-    packet->copy_from(data, offset, headerSize, size);
+    packet->copy_from(data, offset, headerSize + recordHeaderSize, size);
+
+    if (recordHeaderSize > 0) {
+        packet->set_value_at((uint16_t) size, headerSize);
+    }
 
     if (channel == nullptr) {
-        net_mutex_guard guard(m_unreliable_channel_mutex);
-        m_unreliable_channel.push(packet);
+        {
+            net_mutex_guard guard(m_unreliable_channel_mutex);
+            m_unreliable_channel.push(packet);
+        }
+
+        m_net_manager->wake_logic_thread();
     } else {
         channel->add_to_queue(packet);
     }
+
+    if (immediate) {
+        flush();
+    }
+}
+
+void lnl::net_peer::add_to_reliable_channel_send_queue(net_base_channel* channel) {
+    m_channel_send_queue.push(channel);
+    m_net_manager->wake_logic_thread();
 }
@@ -0,0 +1,80 @@
+#include <lnl/net_rate_limiter.h>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+    //splitmix64 finalizer
+    uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+        return value ^ (value >> 31);
+    }
+}
+
+lnl::net_rate_limiter::net_rate_limiter(size_t width) {
+    m_width = 1;
+
+    while (m_width < width) {
+        m_width <<= 1;
+    }
+
+    m_cells.resize(DEPTH * m_width);
+
+    //random per limiter, so nobody can pick sources that share cells with a victim
+    std::random_device device;
+
+    for (auto& seed: m_seeds) {
+        seed = ((uint64_t) device() << 32) | device();
+    }
+}
+
+void lnl::net_rate_limiter::set_rate(double rate, double burst) {
+    m_rate = rate;
+    m_burst = std::max(burst, 1.);
+    m_last_decay = 0;
+    std::fill(m_cells.begin(), m_cells.end(), 0.f);
+}
+
+void lnl::net_rate_limiter::decay(int64_t currentTime) {
+    if (m_last_decay == 0 || currentTime < m_last_decay) {
+        m_last_decay = currentTime;
+        return;
+    }
+
+    auto elapsed = currentTime - m_last_decay;
+
+    if (elapsed < DECAY_INTERVAL) {
+        return;
+    }
+
+    m_last_decay = currentTime;
+    auto leaked = (float) (m_rate * (double) elapsed / TICKS_PER_SECOND);
+
+    for (auto& cell: m_cells) {
+        cell = std::max(cell - leaked, 0.f);
+    }
+}
+
+bool lnl::net_rate_limiter::try_acquire(uint64_t key, int64_t currentTime) {
+    decay(currentTime);
+
+    std::array<float*, DEPTH> cells{};
+    auto spent = (float) m_burst;
+
+    for (size_t row = 0; row < DEPTH; ++row) {
+        cells[row] = &m_cells[row * m_width + (mix(key ^ m_seeds[row]) & (m_width - 1))];
+        spent = std::min(spent, *cells[row]);
+    }
+
+    if (spent + 1.f > (float) m_burst) {
+        return false;
+    }
+
+    //conservative update, cells shared with busier sources already count more than this one
+    for (auto cell: cells) {
+        *cell = std::max(*cell, spent + 1.f);
+    }
+
+    return true;
+}
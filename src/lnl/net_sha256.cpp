@@ -0,0 +1,164 @@
+#include <lnl/net_sha256.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr uint32_t ROUND_CONSTANTS[64] = {
+            0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+            0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+            0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+            0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+            0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+            0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+            0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+            0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+    };
+
+    uint32_t rotr(uint32_t value, int count) {
+        return value >> count | value << (32 - count);
+    }
+
+    //the hash is big endian
+    uint32_t load_be32(const uint8_t* data) {
+        return (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 | (uint32_t) data[2] << 8 | data[3];
+    }
+
+    void store_be32(uint8_t* data, uint32_t value) {
+        data[0] = (uint8_t) (value >> 24);
+        data[1] = (uint8_t) (value >> 16);
+        data[2] = (uint8_t) (value >> 8);
+        data[3] = (uint8_t) value;
+    }
+}
+
+lnl::net_sha256::net_sha256()
+        : m_state{0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19} {}
+
+void lnl::net_sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+
+    for (int i = 0; i < 16; ++i) {
+        w[i] = load_be32(&block[i * 4]);
+    }
+
+    for (int i = 16; i < 64; ++i) {
+        auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto a = m_state[0];
+    auto b = m_state[1];
+    auto c = m_state[2];
+    auto d = m_state[3];
+    auto e = m_state[4];
+    auto f = m_state[5];
+    auto g = m_state[6];
+    auto h = m_state[7];
+
+    for (int i = 0; i < 64; ++i) {
+        auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + ROUND_CONSTANTS[i] + w[i];
+        auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+void lnl::net_sha256::update(const uint8_t* data, size_t size) {
+    m_total += size;
+
+    if (m_buffered > 0) {
+        auto count = std::min(size, BLOCK_SIZE - m_buffered);
+        memcpy(&m_buffer[m_buffered], data, count);
+        m_buffered += count;
+        data += count;
+        size -= count;
+
+        if (m_buffered < BLOCK_SIZE) {
+            return;
+        }
+
+        compress(m_buffer.data());
+        m_buffered = 0;
+    }
+
+    for (; size >= BLOCK_SIZE; data += BLOCK_SIZE, size -= BLOCK_SIZE) {
+        compress(data);
+    }
+
+    if (size > 0) {
+        memcpy(m_buffer.data(), data, size);
+        m_buffered = size;
+    }
+}
+
+void lnl::net_sha256::finish(uint8_t* digest) {
+    auto bits = m_total * 8;
+
+    //a one bit, zeros up to 8 bytes before the end of a block, the length in bits
+    m_buffer[m_buffered++] = 0x80;
+
+    if (m_buffered > BLOCK_SIZE - sizeof(bits)) {
+        memset(&m_buffer[m_buffered], 0, BLOCK_SIZE - m_buffered);
+        compress(m_buffer.data());
+        m_buffered = 0;
+    }
+
+    memset(&m_buffer[m_buffered], 0, BLOCK_SIZE - sizeof(bits) - m_buffered);
+    store_be32(&m_buffer[BLOCK_SIZE - 8], (uint32_t) (bits >> 32));
+    store_be32(&m_buffer[BLOCK_SIZE - 4], (uint32_t) bits);
+    compress(m_buffer.data());
+
+    for (size_t i = 0; i < m_state.size(); ++i) {
+        store_be32(&digest[i * 4], m_state[i]);
+    }
+}
+
+void lnl::hmac_sha256(const uint8_t* key, size_t keySize, const uint8_t* data, size_t size, uint8_t* mac) {
+    uint8_t block[net_sha256::BLOCK_SIZE]{};
+
+    if (keySize > sizeof(block)) {
+        net_sha256 keyHash;
+        keyHash.update(key, keySize);
+        keyHash.finish(block);
+    } else {
+        memcpy(block, key, keySize);
+    }
+
+    uint8_t pad[net_sha256::BLOCK_SIZE];
+    uint8_t innerDigest[net_sha256::DIGEST_SIZE];
+
+    for (size_t i = 0; i < sizeof(pad); ++i) {
+        pad[i] = block[i] ^ 0x36;
+    }
+
+    net_sha256 inner;
+    inner.update(pad, sizeof(pad));
+    inner.update(data, size);
+    inner.finish(innerDigest);
+
+    for (size_t i = 0; i < sizeof(pad); ++i) {
+        pad[i] = block[i] ^ 0x5C;
+    }
+
+    net_sha256 outer;
+    outer.update(pad, sizeof(pad));
+    outer.update(innerDigest, sizeof(innerDigest));
+    outer.finish(mac);
+}
@@ -1,12 +1,18 @@
 #include <lnl/packets/net_connect_accept_packet.h>
 #include <lnl/net_peer.h>
 
-lnl::net_packet* lnl::net_connect_accept_packet::make(int64_t connectTime, uint8_t connectNum, int32_t localPeerId) {
+lnl::net_packet* lnl::net_connect_accept_packet::make(int64_t connectTime, uint8_t connectNum, int32_t localPeerId,
+                                                      const std::optional<net_connect_extensions>& extensions) {
     auto packet = new net_packet(PACKET_PROPERTY::CONNECT_ACCEPT, 0);
     packet->set_value_at(connectTime, 1);
     packet->set_value_at(connectNum, 9);
     packet->set_value_at<uint8_t>(0, 10);
     packet->set_value_at<uint8_t>(localPeerId, 11);
+
+    if (extensions) {
+        extensions->write_to(packet);
+    }
+
     return packet;
 }
 
@@ -20,7 +26,10 @@ lnl::net_packet* lnl::net_connect_accept_packet::make_network_changed(net_peer*
 }
 
 std::unique_ptr<lnl::net_connect_accept_packet> lnl::net_connect_accept_packet::from_data(lnl::net_packet* packet) {
-    if (packet->size() != net_constants::CONNECT_ACCEPT_HEADER_SIZE) {
+    size_t trailerSize;
+    auto extensions = net_connect_extensions::read_from(packet, net_constants::CONNECT_ACCEPT_HEADER_SIZE, trailerSize);
+
+    if (!extensions || packet->size() - trailerSize != net_constants::CONNECT_ACCEPT_HEADER_SIZE) {
         return nullptr;
     }
 
@@ -43,5 +52,6 @@ std::unique_ptr<lnl::net_connect_accept_packet> lnl::net_connect_accept_packet::
         return nullptr;
     }
 
-    return std::make_unique<net_connect_accept_packet>(connectionTime, connectionNumber, peerId, isReused == 1);
+    return std::make_unique<net_connect_accept_packet>(connectionTime, connectionNumber, peerId, isReused == 1,
+                                                       *extensions);
 }
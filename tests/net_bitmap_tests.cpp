@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_bitmap.h>
+
+#include <vector>
+
+TEST(net_bitmap, should_clear_circular_range) {
+    static constexpr size_t BITS = 256;
+
+    std::vector<uint8_t> bits(BITS / 8 + 1, 0xFF);
+
+    lnl::bitmap_clear_circular(bits.data(), BITS, 250, 20);
+
+    for (size_t i = 0; i < BITS; ++i) {
+        bool isSet = (bits[i / 8] & (1 << (i % 8))) != 0;
+        bool shouldBeCleared = i >= 250 || i < 14;
+        ASSERT_EQ(isSet, !shouldBeCleared) << i;
+    }
+
+    //trailing byte is outside of the bitmap
+    ASSERT_EQ(bits.back(), 0xFF);
+}
+
+TEST(net_bitmap, should_visit_common_bits) {
+    static constexpr size_t BITS = 512;
+
+    std::vector<uint8_t> bits(BITS / 8 + 1, 0);
+    std::vector<uint64_t> words(BITS / lnl::BITMAP_WORD_BITS, 0);
+
+    for (size_t idx: {1, 63, 64, 200, 511}) {
+        bits[idx / 8] |= (uint8_t) (1 << (idx % 8));
+        lnl::bitmap_set(words.data(), idx);
+    }
+
+    lnl::bitmap_set(words.data(), 300); //pending only
+    bits[400 / 8] |= 1 << (400 % 8); //acked only
+
+    std::vector<size_t> visited;
+    lnl::bitmap_for_each_common(bits.data(), words.data(), words.size(), [&](size_t idx) {
+        visited.push_back(idx);
+    });
+
+    ASSERT_EQ(visited, (std::vector<size_t>{1, 63, 64, 200, 511}));
+    ASSERT_EQ(lnl::bitmap_distance_to_next_set(words.data(), BITS, 201), 99u);
+    ASSERT_EQ(lnl::bitmap_distance_to_next_set(words.data(), BITS, 301), 210u);
+}
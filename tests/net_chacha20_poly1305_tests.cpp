@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_chacha20_poly1305.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+TEST(net_chacha20_poly1305, should_match_rfc_8439_vector) {
+    uint8_t key[32];
+
+    for (int i = 0; i < 32; ++i) {
+        key[i] = (uint8_t) (0x80 + i);
+    }
+
+    const uint8_t ad[] = {0x50, 0x51, 0x52, 0x53, 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7};
+    const uint8_t expectedStart[] = {0xD3, 0x1A, 0x8D, 0x34, 0x64, 0x8E, 0x60, 0xDB};
+    const uint8_t expectedTag[] = {0x1A, 0xE1, 0x0B, 0x59, 0x4F, 0x09, 0xE2, 0x6A,
+                                   0x7E, 0x90, 0x2E, 0xCB, 0xD0, 0x60, 0x06, 0x91};
+    std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+                       "sunscreen would be it.";
+    std::vector<uint8_t> data(text.begin(), text.end());
+    uint8_t tag[lnl::net_chacha20_poly1305::TAG_SIZE];
+
+    //nonce 07 00 00 00 40 41 42 43 44 45 46 47
+    lnl::net_chacha20_poly1305 cipher(key, 7);
+    lnl::net_aead_job job;
+    job.cipher = &cipher;
+    job.nonce = 0x4746454443424140;
+    job.ad = ad;
+    job.ad_size = sizeof(ad);
+    job.data = data.data();
+    job.size = data.size();
+    job.tag = tag;
+
+    lnl::net_chacha20_poly1305::seal_batch(&job, 1);
+    ASSERT_EQ(memcmp(data.data(), expectedStart, sizeof(expectedStart)), 0);
+    ASSERT_EQ(memcmp(tag, expectedTag, sizeof(expectedTag)), 0);
+
+    lnl::net_chacha20_poly1305::open_batch(&job, 1);
+    ASSERT_TRUE(job.valid);
+    ASSERT_EQ(std::string(data.begin(), data.end()), text);
+}
+
+TEST(net_chacha20_poly1305, should_derive_hchacha20_subkey) {
+    uint8_t key[32];
+
+    for (int i = 0; i < 32; ++i) {
+        key[i] = (uint8_t) i;
+    }
+
+    const uint8_t salt[] = {0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4A,
+                            0x00, 0x00, 0x00, 0x00, 0x31, 0x41, 0x59, 0x27};
+    const uint8_t expected[] = {0x82, 0x41, 0x3B, 0x42, 0x27, 0xB2, 0x7B, 0xFE, 0xD3, 0x0E, 0x42, 0x50, 0x8A, 0x87,
+                                0x7D, 0x73, 0xA0, 0xF9, 0xE4, 0xD5, 0x8A, 0x74, 0xA8, 0x53, 0xC1, 0x2E, 0xC4, 0x13,
+                                0x26, 0xD3, 0xEC, 0xDC};
+    uint8_t subkey[lnl::net_chacha20_poly1305::KEY_SIZE];
+
+    lnl::net_chacha20_poly1305::derive_key(key, salt, subkey);
+    ASSERT_EQ(memcmp(subkey, expected, sizeof(expected)), 0);
+}
+
+TEST(net_chacha20_poly1305, should_open_batches_of_mixed_peers) {
+    static constexpr size_t COUNT = 37;
+    std::minstd_rand random(42);
+    std::vector<std::unique_ptr<lnl::net_chacha20_poly1305>> ciphers;
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        uint8_t key[lnl::net_chacha20_poly1305::KEY_SIZE];
+
+        for (auto& byte: key) {
+            byte = (uint8_t) random();
+        }
+
+        ciphers.push_back(std::make_unique<lnl::net_chacha20_poly1305>(key, i));
+    }
+
+    std::vector<std::vector<uint8_t>> plain(COUNT);
+    std::vector<std::vector<uint8_t>> data(COUNT);
+    std::vector<std::vector<uint8_t>> tags(COUNT, std::vector<uint8_t>(lnl::net_chacha20_poly1305::TAG_SIZE));
+    std::vector<lnl::net_aead_job> jobs(COUNT);
+    uint8_t ad = 0x42;
+
+    //sizes on both sides of the block size, empty ones included
+    for (size_t i = 0; i < COUNT; ++i) {
+        plain[i].resize(i * i * 7 % 700);
+
+        for (auto& byte: plain[i]) {
+            byte = (uint8_t) random();
+        }
+
+        data[i] = plain[i];
+        jobs[i].cipher = ciphers[i % ciphers.size()].get();
+        jobs[i].nonce = i * 1000003;
+        jobs[i].ad = &ad;
+        jobs[i].ad_size = 1;
+        jobs[i].data = data[i].data();
+        jobs[i].size = data[i].size();
+        jobs[i].tag = tags[i].data();
+    }
+
+    //one at a time is the reference for the batch
+    std::vector<std::vector<uint8_t>> single = data;
+    std::vector<std::vector<uint8_t>> singleTags = tags;
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        auto job = jobs[i];
+        job.data = single[i].data();
+        job.tag = singleTags[i].data();
+        lnl::net_chacha20_poly1305::seal_batch(&job, 1);
+    }
+
+    lnl::net_chacha20_poly1305::seal_batch(jobs.data(), COUNT);
+    ASSERT_EQ(data, single);
+    ASSERT_EQ(tags, singleTags);
+
+    data[5][0] ^= 1;
+    tags[6][0] ^= 1;
+    jobs[7].nonce++;
+
+    lnl::net_chacha20_poly1305::open_batch(jobs.data(), COUNT);
+
+    for (size_t i = 0; i < COUNT; ++i) {
+        if (i >= 5 && i <= 7) {
+            ASSERT_FALSE(jobs[i].valid);
+        } else {
+            ASSERT_TRUE(jobs[i].valid);
+            ASSERT_EQ(data[i], plain[i]);
+        }
+    }
+}
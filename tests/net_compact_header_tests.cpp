@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_compact_header.h>
+
+#include <vector>
+
+TEST(net_compact_header, should_restore_merged_records) {
+    static constexpr uint8_t CONNECTION_NUMBER = 2;
+
+    std::vector<lnl::net_packet> records;
+
+    auto addChanneled = [&](lnl::PACKET_PROPERTY property, uint16_t sequence, uint8_t channelId, size_t size) {
+        auto& packet = records.emplace_back(property, size);
+        packet.set_sequence(sequence);
+        packet.set_channel_id(channelId);
+
+        for (size_t i = packet.get_header_size(); i < packet.size(); ++i) {
+            packet.data()[i] = (uint8_t) (i * 13 + sequence);
+        }
+
+        return &packet;
+    };
+
+    records.reserve(8);
+    addChanneled(lnl::PACKET_PROPERTY::CHANNELED, 100, 2, 5);
+    addChanneled(lnl::PACKET_PROPERTY::CHANNELED, 101, 2, 7);
+    addChanneled(lnl::PACKET_PROPERTY::ACK, 7, 3, 8);
+    records.emplace_back(lnl::PACKET_PROPERTY::UNRELIABLE, 3).data()[1] = 42;
+
+    auto fragment = addChanneled(lnl::PACKET_PROPERTY::CHANNELED, lnl::net_constants::MAX_SEQUENCE - 1, 2, 20);
+    fragment->mark_fragmented();
+    fragment->set_fragment_id(9);
+    fragment->set_fragment_part(300);
+    fragment->set_total_fragments(301);
+
+    //wraps around, still the next sequence
+    addChanneled(lnl::PACKET_PROPERTY::CHANNELED_ACK, 0, 2, 4);
+
+    lnl::net_packet merged(lnl::PACKET_PROPERTY::MERGED, 0);
+
+    for (auto& record: records) {
+        record.set_connection_number(CONNECTION_NUMBER);
+
+        auto pos = merged.size();
+        merged.resize(pos + 2 + record.size());
+        merged.set_value_at((uint16_t) record.size(), pos);
+        merged.copy_from(record.data(), 0, pos + 2, record.size());
+    }
+
+    lnl::net_packet compact(lnl::PACKET_PROPERTY::COMPACT_MERGED, lnl::net_constants::MAX_PACKET_SIZE);
+    compact.set_connection_number(CONNECTION_NUMBER);
+
+    auto compactSize = lnl::net_compact_writer::write(&merged, merged.size(), &compact, compact.size());
+    ASSERT_GT(compactSize, 0);
+    ASSERT_LT(compactSize, merged.size());
+    compact.resize(compactSize);
+
+    //too small for the packed records
+    ASSERT_EQ(lnl::net_compact_writer::write(&merged, merged.size(), &compact, 16), 0);
+
+    lnl::net_compact_reader reader(&compact);
+    lnl::net_packet restored;
+
+    for (auto& record: records) {
+        ASSERT_TRUE(reader.has_next());
+        ASSERT_TRUE(reader.read_next(&restored));
+        ASSERT_EQ(restored.size(), record.size());
+        ASSERT_EQ(memcmp(restored.data(), record.data(), record.size()), 0);
+    }
+
+    ASSERT_FALSE(reader.has_next());
+}
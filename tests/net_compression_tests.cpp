@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_compression.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+TEST(net_compression, should_round_trip_with_and_without_dictionary) {
+    std::string text;
+
+    for (int i = 0; i < 40; ++i) {
+        text += R"({"id":)" + std::to_string(i * 7919 % 1000) + R"(,"position":{"x":1.5,"y":-2.25},"state":"idle"})";
+    }
+
+    std::string dictionaryText = R"({"id":0,"position":{"x":0,"y":0},"state":"idle"})";
+    lnl::net_lz_dictionary dictionary((const uint8_t*) dictionaryText.data(), dictionaryText.size());
+
+    lnl::net_lz_codec codec;
+    std::vector<uint8_t> compressed(text.size());
+    std::vector<uint8_t> restored(text.size());
+    auto src = (const uint8_t*) text.data();
+
+    auto size = codec.compress(src, text.size(), compressed.data(), compressed.size());
+    ASSERT_GT(size, 0);
+    ASSERT_LT(size, text.size() / 4);
+    ASSERT_TRUE(lnl::net_lz_codec::decompress(compressed.data(), size, restored.data(), restored.size()));
+    ASSERT_EQ(memcmp(restored.data(), src, text.size()), 0);
+
+    //a single short message has nothing of its own to refer to, the dictionary has
+    auto messageSize = text.find('}', text.find('}') + 1) + 1;
+    auto plainSize = codec.compress(src, messageSize, compressed.data(), compressed.size());
+    size = codec.compress(src, messageSize, compressed.data(), compressed.size(), &dictionary);
+    ASSERT_GT(size, 0);
+    ASSERT_LT(size, plainSize / 2);
+    ASSERT_TRUE(lnl::net_lz_codec::decompress(compressed.data(), size, restored.data(), messageSize, &dictionary));
+    ASSERT_EQ(memcmp(restored.data(), src, messageSize), 0);
+
+    //without the dictionary the offsets point before the data
+    ASSERT_FALSE(lnl::net_lz_codec::decompress(compressed.data(), size, restored.data(), messageSize));
+}
+
+TEST(net_compression, should_reject_what_does_not_fit) {
+    std::minstd_rand random(42);
+    std::vector<uint8_t> noise(1000);
+
+    for (auto& byte: noise) {
+        byte = (uint8_t) random();
+    }
+
+    lnl::net_lz_codec codec;
+    std::vector<uint8_t> compressed(noise.size() * 2);
+    std::vector<uint8_t> restored(noise.size());
+
+    ASSERT_EQ(codec.compress(noise.data(), noise.size(), compressed.data(), noise.size() - 1), 0);
+
+    auto size = codec.compress(noise.data(), noise.size(), compressed.data(), compressed.size());
+    ASSERT_GT(size, noise.size());
+    ASSERT_TRUE(lnl::net_lz_codec::decompress(compressed.data(), size, restored.data(), restored.size()));
+    ASSERT_EQ(restored, noise);
+
+    //truncated input and a wrong size are both malformed
+    ASSERT_FALSE(lnl::net_lz_codec::decompress(compressed.data(), size / 2, restored.data(), restored.size()));
+    ASSERT_FALSE(lnl::net_lz_codec::decompress(compressed.data(), size, restored.data(), restored.size() - 1));
+}
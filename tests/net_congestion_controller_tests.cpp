@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <lnl/congestion/net_aimd_congestion_controller.h>
+#include <lnl/congestion/net_delay_congestion_controller.h>
+#include <lnl/net_utils.h>
+
+TEST(net_congestion_controller, aimd_should_halve_once_per_recovery) {
+    static constexpr size_t SEGMENT = 1000;
+
+    lnl::net_aimd_congestion_controller controller(SEGMENT);
+    auto initialWindow = controller.congestion_window();
+
+    int64_t time = lnl::TICKS_PER_SECOND;
+
+    while (controller.can_send(SEGMENT)) {
+        controller.on_packet_sent(SEGMENT, time);
+    }
+
+    ASSERT_EQ(controller.state().bytes_in_flight, initialWindow);
+
+    controller.on_packet_lost(SEGMENT, time, time + lnl::TICKS_PER_MILLISECOND * 100);
+    controller.on_packet_lost(SEGMENT, time, time + lnl::TICKS_PER_MILLISECOND * 101);
+
+    ASSERT_EQ(controller.congestion_window(), initialWindow / 2);
+    ASSERT_EQ(controller.state().loss_events, 1u);
+    ASSERT_EQ(controller.state().bytes_in_flight, initialWindow - 2 * SEGMENT);
+}
+
+TEST(net_congestion_controller, delay_based_should_follow_bandwidth_delay_product) {
+    static constexpr size_t SEGMENT = 1000;
+    static constexpr int64_t RTT = 50 * lnl::TICKS_PER_MILLISECOND;
+    //1000 bytes per millisecond
+    static constexpr double BANDWIDTH = SEGMENT * 1000.;
+
+    lnl::net_delay_congestion_controller controller(SEGMENT);
+
+    int64_t time = lnl::TICKS_PER_SECOND;
+
+    for (int i = 0; i < 2000; ++i) {
+        controller.on_packet_sent(SEGMENT, time);
+        time += lnl::TICKS_PER_MILLISECOND;
+        controller.on_packet_acked(SEGMENT, RTT, time);
+    }
+
+    auto state = controller.state();
+
+    ASSERT_EQ(state.min_rtt, RTT);
+    ASSERT_NEAR(state.pacing_rate, BANDWIDTH, BANDWIDTH * 0.3);
+    ASSERT_NEAR((double) state.congestion_window, 2. * BANDWIDTH * 0.05, BANDWIDTH * 0.05);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_crc32c.h>
+
+#include <random>
+#include <vector>
+
+TEST(net_crc32c, should_match_known_values) {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    ASSERT_EQ(lnl::crc32c(check, sizeof(check)), 0xE3069283);
+
+    //rfc 3720 b.4
+    std::vector<uint8_t> zeros(32, 0);
+    std::vector<uint8_t> ones(32, 0xFF);
+    ASSERT_EQ(lnl::crc32c(zeros.data(), zeros.size()), 0x8A9136AA);
+    ASSERT_EQ(lnl::crc32c(ones.data(), ones.size()), 0x62A8AB43);
+
+    ASSERT_EQ(lnl::crc32c(nullptr, 0), 0);
+}
+
+TEST(net_crc32c, should_batch_like_single_calls) {
+    static constexpr size_t COUNT = 16;
+    std::minstd_rand random(42);
+    std::vector<std::vector<uint8_t>> buffers(COUNT);
+    std::vector<const uint8_t*> data(COUNT);
+    std::vector<size_t> sizes(COUNT);
+
+    //lengths around the 8 byte steps and the shortest of an interleaved group
+    for (size_t i = 0; i < COUNT; ++i) {
+        buffers[i].resize(i * 97 % 1500 + i % 9);
+
+        for (auto& byte: buffers[i]) {
+            byte = (uint8_t) random();
+        }
+
+        data[i] = buffers[i].data();
+        sizes[i] = buffers[i].size();
+    }
+
+    for (size_t count = 0; count <= COUNT; ++count) {
+        std::vector<uint32_t> results(COUNT, 0);
+        lnl::crc32c_batch(data.data(), sizes.data(), results.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(results[i], lnl::crc32c(data[i], sizes[i]));
+        }
+    }
+}
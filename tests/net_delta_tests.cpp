@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_delta.h>
+
+#include <random>
+
+TEST(net_delta, should_round_trip_against_baseline) {
+    static constexpr size_t SIZES[] = {0, 1, 15, 16, 33, 200, 1400};
+
+    std::minstd_rand random(7);
+    lnl::net_delta_codec codec;
+
+    for (auto baselineSize: SIZES) {
+        for (auto size: SIZES) {
+            std::vector<uint8_t> baseline(baselineSize);
+            std::vector<uint8_t> data(size);
+
+            for (auto& value: baseline) {
+                value = (uint8_t) random();
+            }
+
+            //mostly unchanged with a few edits, including short gaps inside literals
+            for (size_t i = 0; i < size; ++i) {
+                data[i] = i < baselineSize && random() % 8 != 0 ? baseline[i] : (uint8_t) random();
+            }
+
+            std::vector<uint8_t> encoded(size + 16);
+            size_t encodedSize;
+            ASSERT_TRUE(codec.encode(baseline.data(), baseline.size(), data.data(), data.size(),
+                                     encoded.data(), encoded.size(), encodedSize));
+
+            std::vector<uint8_t> decoded(size);
+            ASSERT_TRUE(lnl::net_delta_codec::decode(baseline.data(), baseline.size(), encoded.data(), encodedSize,
+                                                     decoded.data(), decoded.size()));
+            ASSERT_EQ(decoded, data);
+        }
+    }
+}
+
+TEST(net_delta, should_encode_unchanged_bytes_for_free) {
+    std::vector<uint8_t> baseline(1000, 42);
+    std::vector<uint8_t> data(baseline);
+    data[500] = 1;
+
+    lnl::net_delta_codec codec;
+    std::vector<uint8_t> encoded(data.size());
+    size_t encodedSize;
+
+    ASSERT_TRUE(codec.encode(baseline.data(), baseline.size(), baseline.data(), baseline.size(),
+                             encoded.data(), encoded.size(), encodedSize));
+    ASSERT_EQ(encodedSize, 0);
+
+    ASSERT_TRUE(codec.encode(baseline.data(), baseline.size(), data.data(), data.size(),
+                             encoded.data(), encoded.size(), encodedSize));
+    //two byte zero run, one byte literal count and the literal
+    ASSERT_EQ(encodedSize, 4);
+
+    //doesn't fit
+    ASSERT_FALSE(codec.encode(baseline.data(), baseline.size(), data.data(), data.size(),
+                              encoded.data(), 3, encodedSize));
+
+    //runs past the end are rejected
+    std::vector<uint8_t> decoded(10);
+    ASSERT_FALSE(lnl::net_delta_codec::decode(baseline.data(), baseline.size(), encoded.data(), encodedSize,
+                                              decoded.data(), decoded.size()));
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_fec.h>
+
+TEST(net_fec, should_recover_single_loss_per_group) {
+    static constexpr size_t GROUP_SIZE = 4;
+    static constexpr size_t LOST = 2;
+
+    lnl::net_fec_encoder encoder;
+    lnl::net_fec_decoder decoder;
+    std::vector<lnl::net_packet> wrapped;
+
+    for (size_t i = 0; i < GROUP_SIZE; ++i) {
+        lnl::net_packet packet(lnl::PACKET_PROPERTY::UNRELIABLE, 10 + i * 7);
+
+        for (size_t j = 1; j < packet.size(); ++j) {
+            packet.data()[j] = (uint8_t) (i * 31 + j);
+        }
+
+        wrapped.emplace_back(lnl::PACKET_PROPERTY::FEC_DATA, 0);
+        encoder.wrap(&packet, &wrapped.back());
+    }
+
+    lnl::net_packet repair(lnl::PACKET_PROPERTY::FEC_REPAIR, 0);
+    encoder.write_repair(&repair);
+
+    for (size_t i = 0; i < GROUP_SIZE; ++i) {
+        if (i != LOST) {
+            ASSERT_EQ(decoder.add(&wrapped[i]), 0);
+        }
+    }
+
+    auto recoveredSize = decoder.add(&repair);
+    ASSERT_EQ(recoveredSize, wrapped[LOST].size() - lnl::net_constants::FEC_DATA_HEADER_SIZE);
+
+    std::vector<uint8_t> recovered(recoveredSize);
+    decoder.copy_recovered(recovered.data());
+    ASSERT_EQ(memcmp(recovered.data(), &wrapped[LOST].data()[lnl::net_constants::FEC_DATA_HEADER_SIZE],
+                     recoveredSize), 0);
+
+    //the late original changes nothing
+    ASSERT_EQ(decoder.add(&wrapped[LOST]), 0);
+}
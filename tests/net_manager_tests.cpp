@@ -3,6 +3,12 @@
 #include <lnl/net_manager.h>
 #include <lnl/net_event_based_listener.h>
 
+#include <mutex>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+
 TEST(net_manager, should_connect_ipv4) {
     static constexpr auto MAX_RETRIES = 15;
     static lnl::net_data_writer writer;
@@ -135,4 +141,2212 @@ TEST(net_manager, should_send_and_receive) {
 
     ASSERT_TRUE(isSent);
     ASSERT_TRUE(isReceived);
-}
\ No newline at end of file
+}
+
+TEST(net_manager, should_stop_without_waiting_for_poll) {
+    lnl::net_event_based_listener listener;
+
+    auto manager = std::make_unique<lnl::net_manager>(&listener);
+    manager->start();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto start = std::chrono::steady_clock::now();
+    manager.reset();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 250);
+}
+
+TEST(net_manager, should_discover_largest_mtu_right_after_connect) {
+    static constexpr auto MAX_RETRIES = 15;
+    static thread_local lnl::net_data_writer writer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //the server answers probes only up to its own profile
+    client.mtu_profile = lnl::MTU_PROFILE::LOOPBACK;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    auto clientPeer = client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        if (clientPeer->connection_state() == lnl::CONNECTION_STATE::CONNECTED &&
+            clientPeer->mtu() == server.max_packet_size()) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    //all candidates are probed at once, loopback takes the largest in the first round
+    ASSERT_EQ(clientPeer->connection_state(), lnl::CONNECTION_STATE::CONNECTED);
+    ASSERT_EQ(clientPeer->mtu(), lnl::net_constants::MAX_PACKET_SIZE);
+    ASSERT_EQ(server.max_packet_size(), lnl::net_constants::MAX_PACKET_SIZE);
+}
+
+TEST(net_manager, should_send_large_messages_with_loopback_mtu_profile) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr size_t MESSAGE_SIZE = 4 * 1024 * 1024;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<uint8_t> message(MESSAGE_SIZE);
+    bool isReceived = false;
+
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = (uint8_t) (i * 7 + i / 251);
+    }
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        isReceived = reader.remaining() == MESSAGE_SIZE &&
+                     memcmp(&reader.data()[reader.position()], message.data(), MESSAGE_SIZE) == 0;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->mtu_profile = lnl::MTU_PROFILE::LOOPBACK;
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    auto clientPeer = client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        if (clientPeer->connection_state() == lnl::CONNECTION_STATE::CONNECTED &&
+            clientPeer->mtu() == client.max_packet_size()) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(clientPeer->mtu(), lnl::net_constants::POSSIBLE_MTU.back());
+
+    //65 fragments instead of about 2950 with the internet profile
+    clientPeer->send(message, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+
+    for (int _ = 0; _ < MAX_RETRIES && !isReceived; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(isReceived);
+}
+
+TEST(net_manager, should_deliver_ordered_with_large_window) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 1500;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    bool inOrder = true;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        }
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        inOrder = inOrder && reader.read<uint32_t>() == received;
+        received++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    server.reliable_window_size = 1024;
+    client.reliable_window_size = 1024;
+
+    ASSERT_EQ(client.get_channel_window_size(0), 1024);
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_TRUE(inOrder);
+}
+
+TEST(net_manager, should_negotiate_smaller_window) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 1000;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<uint32_t> received(2, 0);
+    std::shared_ptr<lnl::net_peer> clientPeer;
+    std::shared_ptr<lnl::net_peer> serverPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.peer_connected().subscribe([&](auto& peer) {
+        serverPeer = peer;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        received[channel]++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //the acks of differently sized windows would not be understood by the other side
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = 2;
+    }
+
+    server.reliable_window_size = 1024;
+    client.reliable_window_size = 256;
+    client.set_channel_window_size(1, 512);
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && (!clientPeer || !serverPeer); ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+    ASSERT_TRUE(serverPeer);
+
+    for (auto& peer: {clientPeer, serverPeer}) {
+        ASSERT_EQ(peer->window_size(0), 256);
+        ASSERT_EQ(peer->window_size(1), 512);
+    }
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        writer.reset();
+        writer.write(i);
+        clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        clientPeer->send(writer, 1, lnl::DELIVERY_METHOD::RELIABLE_UNORDERED);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && received[0] + received[1] < MESSAGES * 2; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received[0], MESSAGES);
+    ASSERT_EQ(received[1], MESSAGES);
+}
+
+TEST(net_manager, should_deliver_ordered_across_sequence_wrap) {
+    static constexpr auto MAX_RETRIES = 1500;
+    static constexpr uint32_t MESSAGES = lnl::net_constants::MAX_SEQUENCE + 1000;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    bool inOrder = true;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        }
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        inOrder = inOrder && reader.read<uint32_t>() == received;
+        received++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //windows that don't divide MAX_SEQUENCE would reuse slots of live sequences after the wrap
+    server.reliable_window_size = 192;
+    client.reliable_window_size = 320;
+
+    ASSERT_EQ(server.get_channel_window_size(0), 256);
+    ASSERT_EQ(client.get_channel_window_size(0), 512);
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_TRUE(inOrder);
+}
+
+TEST(net_manager, should_deliver_with_compound_acks) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 500;
+    static constexpr uint8_t CHANNELS = 3;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            peer->send(writer, (uint8_t) (i % CHANNELS), lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        }
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        received++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = CHANNELS;
+        manager->compound_acks_enabled = true;
+        manager->ack_delay = 5;
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_TRUE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::COMPOUND_ACK));
+}
+
+TEST(net_manager, should_deliver_with_piggybacked_acks) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 500;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t echoed = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        }
+    });
+
+    //echo on the same channel, so acks of both directions can ride on data
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        writer.reset();
+        writer.write(reader.read<uint32_t>());
+        peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    });
+
+    clientListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        echoed++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->piggyback_acks_enabled = true;
+        manager->ack_delay = 5;
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && echoed < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(echoed, MESSAGES);
+    ASSERT_TRUE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::PIGGYBACK_ACK));
+    ASSERT_FALSE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::COMPOUND_ACK));
+}
+
+TEST(net_manager, should_deliver_redundant_messages_once) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr uint32_t MESSAGES = 300;
+    static constexpr uint8_t CHANNEL = 1;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<uint32_t> received(MESSAGES, 0);
+    uint32_t wrongChannel = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        if (channel != CHANNEL || method != lnl::DELIVERY_METHOD::REDUNDANT) {
+            wrongChannel++;
+            return;
+        }
+
+        received[reader.read<uint32_t>() % MESSAGES]++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //extended channel ids don't depend on the channel counts
+    server.channels_count = 2;
+    client.channels_count = 5;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    server.simulation_packet_loss_chance = 20;
+    server.simulate_packet_loss = true;
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        writer.reset();
+        writer.write(i);
+        clientPeer->send(writer, CHANNEL, lnl::DELIVERY_METHOD::REDUNDANT);
+
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    for (int _ = 0; _ < 10; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    uint32_t delivered = 0;
+
+    for (auto count: received) {
+        ASSERT_LE(count, 1);
+        delivered += count;
+    }
+
+    ASSERT_EQ(wrongChannel, 0);
+    //a message is lost only when every packet repeating it is
+    ASSERT_GE(delivered, MESSAGES * 95 / 100);
+}
+
+TEST(net_manager, should_report_extended_channels_taken_by_basic_ones) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr uint8_t CHANNELS = 40;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    std::vector<std::string> errors;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        if (channel == 0 && method == lnl::DELIVERY_METHOD::REDUNDANT) {
+            received++;
+        }
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    clientListener.network_error().subscribe([&](auto& endpoint, auto code, auto& message) {
+        errors.push_back(message);
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = CHANNELS;
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    //the ids of the last channel belong to basic channels with this many of them
+    writer.reset();
+    writer.write((uint32_t) 1);
+    clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::REDUNDANT);
+    clientPeer->send(writer, CHANNELS - 1, lnl::DELIVERY_METHOD::REDUNDANT);
+
+    for (int _ = 0; _ < MAX_RETRIES && (received == 0 || errors.empty()); ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, 1);
+    ASSERT_EQ(errors.size(), 1);
+}
+
+TEST(net_manager, should_notify_unreliable_delivery) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr uint32_t MESSAGES = 300;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<bool> received(MESSAGES, false);
+    std::vector<uint32_t> notified(MESSAGES, 0);
+    std::vector<bool> delivered(MESSAGES, false);
+    uint32_t lostCount = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        ASSERT_EQ(method, lnl::DELIVERY_METHOD::UNRELIABLE_NOTIFIED);
+        auto idx = reader.read<uint32_t>() % MESSAGES;
+        ASSERT_FALSE(received[idx]);
+        received[idx] = true;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    clientListener.message_delivered().subscribe([&](auto& peer, void* userData) {
+        auto idx = (uintptr_t) userData - 1;
+        notified[idx]++;
+        delivered[idx] = true;
+    });
+
+    clientListener.message_lost().subscribe([&](auto& peer, void* userData) {
+        notified[(uintptr_t) userData - 1]++;
+        lostCount++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    server.simulation_packet_loss_chance = 20;
+    server.simulate_packet_loss = true;
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        writer.reset();
+        writer.write(i);
+        clientPeer->send_with_delivery_event(writer, 0, lnl::DELIVERY_METHOD::UNRELIABLE_NOTIFIED,
+                                             (void*) (uintptr_t) (i + 1));
+
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    for (int _ = 0; _ < 50; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        //every message is reported once, and only received ones as delivered
+        ASSERT_EQ(notified[i], 1);
+        ASSERT_TRUE(!delivered[i] || received[i]);
+    }
+
+    ASSERT_GT(lostCount, 0);
+}
+
+TEST(net_manager, should_reconstruct_delta_snapshots) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr uint32_t SNAPSHOTS = 200;
+    static constexpr uint32_t ENTITIES = 50;
+    static constexpr uint16_t KEY = 3;
+    static thread_local lnl::net_data_writer writer;
+
+    //entity positions, one entity moves per snapshot
+    auto writeSnapshot = [](lnl::net_data_writer& dst, uint32_t tick) {
+        dst.reset();
+        dst.write(tick);
+
+        for (uint32_t entity = 0; entity < ENTITIES; ++entity) {
+            dst.write(entity);
+            dst.write(entity * 1000 + (tick + ENTITIES - entity) / ENTITIES);
+        }
+    };
+
+    uint32_t received = 0;
+    uint32_t corrupted = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        ASSERT_EQ(method, lnl::DELIVERY_METHOD::DELTA);
+
+        auto snapshot = &reader.data()[reader.position()];
+        auto snapshotSize = reader.remaining();
+
+        lnl::net_data_writer expected;
+        writeSnapshot(expected, reader.read<uint32_t>());
+
+        if (snapshotSize != expected.size() || memcmp(snapshot, expected.data(), expected.size()) != 0) {
+            corrupted++;
+        }
+
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    server.simulation_packet_loss_chance = 20;
+    server.simulate_packet_loss = true;
+
+    for (uint32_t tick = 0; tick < SNAPSHOTS; ++tick) {
+        writeSnapshot(writer, tick);
+        clientPeer->send_delta(writer, KEY);
+
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    for (int _ = 0; _ < 10; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(corrupted, 0);
+    ASSERT_GE(received, SNAPSHOTS / 2);
+}
+
+TEST(net_manager, should_schedule_channels_by_priority_and_weight) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr uint32_t MESSAGES = 60;
+    static constexpr uint32_t PAYLOAD_SIZE = 400;
+    static thread_local lnl::net_data_writer writer;
+
+    //channel 2 outranks the others, channel 1 gets three quanta per round to one of channel 0
+    std::vector<uint32_t> received(3, 0);
+    uint32_t urgentLast = 0;
+    uint32_t total = 0;
+    std::vector<uint32_t> receivedAtHalf;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        received[channel]++;
+        total++;
+
+        if (channel == 2) {
+            urgentLast = total;
+        }
+
+        if (total == MESSAGES) {
+            receivedAtHalf = received;
+        }
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = 3;
+    }
+
+    client.set_channel_priority(1, 0, 3);
+    client.set_channel_priority(2, 1);
+    client.max_egress_rate = 64 * 1024;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    writer.reset();
+
+    for (uint32_t i = 0; i < PAYLOAD_SIZE; ++i) {
+        writer.write((uint8_t) i);
+    }
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        clientPeer->send(writer, 1, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    }
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        clientPeer->send(writer, 2, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && total < MESSAGES * 2 + 5; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(total, MESSAGES * 2 + 5);
+    ASSERT_EQ(received[2], 5);
+    //the backlog of the other channels doesn't hold the urgent one back
+    ASSERT_LT(urgentLast, MESSAGES / 2);
+    ASSERT_GT(receivedAtHalf[1], receivedAtHalf[0] * 3 / 2);
+}
+
+TEST(net_manager, should_deliver_bundled_reliable_messages_in_order) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 1000;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    uint32_t outOfOrder = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        if (reader.remaining() != sizeof(uint32_t) || reader.read<uint32_t>() != received) {
+            outOfOrder++;
+        }
+
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+
+        //far more messages than window slots
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            writer.reset();
+            writer.write(i);
+            peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        }
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->reliable_bundling_enabled = true;
+    }
+
+    server.simulation_packet_loss_chance = 10;
+    server.simulate_packet_loss = true;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_EQ(outOfOrder, 0);
+    ASSERT_TRUE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::RELIABLE_BUNDLE));
+}
+
+TEST(net_manager, should_deliver_merged_messages_with_compact_headers) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 500;
+    static constexpr uint8_t CHANNELS = 2;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received[CHANNELS] = {};
+    uint32_t outOfOrder = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        if (channel >= CHANNELS ||
+            reader.remaining() != sizeof(uint32_t) ||
+            reader.read<uint32_t>() != received[channel]) {
+            outOfOrder++;
+            return;
+        }
+
+        received[channel]++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+
+        //small messages of both channels interleave in the same merged packets
+        for (uint32_t i = 0; i < MESSAGES; ++i) {
+            for (uint8_t channel = 0; channel < CHANNELS; ++channel) {
+                writer.reset();
+                writer.write(i);
+                peer->send(writer, channel, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+            }
+        }
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = CHANNELS;
+        manager->compact_headers_enabled = true;
+    }
+
+    server.simulation_packet_loss_chance = 10;
+    server.simulate_packet_loss = true;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received[0] + received[1] < CHANNELS * MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received[0], MESSAGES);
+    ASSERT_EQ(received[1], MESSAGES);
+    ASSERT_EQ(outOfOrder, 0);
+    ASSERT_TRUE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::COMPACT_HEADER));
+}
+
+TEST(net_manager, should_compress_datagrams_with_channel_dictionary) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 300;
+    static thread_local lnl::net_data_writer writer;
+
+    std::string dictionaryText = R"({"type":"move","entity":0,"x":0,"y":0,"z":0})";
+    std::vector<uint8_t> dictionary(dictionaryText.begin(), dictionaryText.end());
+
+    uint32_t received = 0;
+    uint32_t corrupted = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    auto message = [](uint32_t i) {
+        return R"({"type":"move","entity":)" + std::to_string(i) + R"(,"x":)" + std::to_string(i % 17) +
+               R"(,"y":1,"z":)" + std::to_string(i % 5) + "}";
+    };
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        auto expected = message(received);
+
+        if (reader.remaining() != expected.size() ||
+            memcmp(&reader.data()[reader.position()], expected.data(), expected.size()) != 0) {
+            corrupted++;
+        }
+
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->compression_enabled = true;
+        manager->compression_min_size = 32;
+        manager->set_channel_dictionary(0, dictionary);
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        auto text = message(i);
+        writer.reset();
+        writer.write((const uint8_t*) text.data(), 0, text.size());
+        clientPeer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_EQ(corrupted, 0);
+
+    auto stats = clientPeer->compression_stats();
+    ASSERT_GT(stats.compressed_packets, 0);
+    ASSERT_LT(stats.ratio(), 0.5);
+    ASSERT_GT(stats.compress_time, 0);
+    ASSERT_GT(server.first_peer()->compression_stats().decompressed_packets, 0);
+}
+
+TEST(net_manager, should_verify_crc32c_of_every_datagram) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 100;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    uint32_t corrupted = 0;
+    uint32_t requests = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    //every tenth message is fragmented
+    auto message = [](uint32_t i) {
+        std::vector<uint8_t> data(i % 10 == 0 ? 5000 : 10 + i);
+
+        for (size_t pos = 0; pos < data.size(); ++pos) {
+            data[pos] = (uint8_t) (pos * 31 + i);
+        }
+
+        return data;
+    };
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+    lnl::net_event_based_listener intruderListener;
+
+    serverListener.connection_request().subscribe([&](auto& request) {
+        requests++;
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        auto expected = message(received);
+
+        if (reader.remaining() != expected.size() ||
+            memcmp(&reader.data()[reader.position()], expected.data(), expected.size()) != 0) {
+            corrupted++;
+        }
+
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+    lnl::net_manager intruder(&intruderListener);
+
+    server.crc32c_enabled = true;
+    client.crc32c_enabled = true;
+
+    server.start();
+    client.start();
+    intruder.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        auto data = message(i);
+        writer.reset();
+        writer.write(data.data(), 0, data.size());
+        clientPeer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_EQ(corrupted, 0);
+    ASSERT_EQ(server.corrupted_packets(), 0);
+    ASSERT_EQ(client.corrupted_packets(), 0);
+
+    //the probes carry the checksum too, so the mtu is the candidate datagram minus it
+    ASSERT_EQ(clientPeer->mtu(), lnl::net_constants::MAX_PACKET_SIZE - lnl::net_constants::CRC32C_SIZE);
+
+    //a manager without the layer sends datagrams whose last bytes are not a checksum of the rest
+    intruder.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < 20; ++_) {
+        intruder.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_GT(server.corrupted_packets(), 0);
+    ASSERT_EQ(requests, 1);
+}
+
+TEST(net_manager, should_encrypt_connections) {
+    static constexpr auto MAX_RETRIES = 200;
+    static constexpr uint32_t MESSAGES = 100;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    uint32_t corrupted = 0;
+    uint32_t requests = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+    std::shared_ptr<lnl::net_peer> intruderPeer;
+
+    auto message = [](uint32_t i) {
+        std::vector<uint8_t> data(i % 10 == 0 ? 5000 : 10 + i);
+
+        for (size_t pos = 0; pos < data.size(); ++pos) {
+            data[pos] = (uint8_t) (pos * 31 + i);
+        }
+
+        return data;
+    };
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+    lnl::net_event_based_listener intruderListener;
+    lnl::net_event_based_listener plainListener;
+
+    serverListener.connection_request().subscribe([&](auto& request) {
+        requests++;
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        auto expected = message(received);
+
+        if (reader.remaining() != expected.size() ||
+            memcmp(&reader.data()[reader.position()], expected.data(), expected.size()) != 0) {
+            corrupted++;
+        }
+
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    intruderListener.peer_connected().subscribe([&](auto& peer) {
+        intruderPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+    lnl::net_manager intruder(&intruderListener);
+    lnl::net_manager plain(&plainListener);
+
+    for (auto manager: {&server, &client, &intruder}) {
+        manager->encryption_enabled = true;
+
+        for (size_t i = 0; i < manager->encryption_key.size(); ++i) {
+            manager->encryption_key[i] = (uint8_t) (manager == &intruder ? i + 1 : i);
+        }
+    }
+
+    server.start();
+    client.start();
+    intruder.start();
+    plain.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        auto data = message(i);
+        writer.reset();
+        writer.write(data.data(), 0, data.size());
+        clientPeer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_EQ(corrupted, 0);
+    ASSERT_EQ(server.unauthenticated_packets(), 0);
+    ASSERT_EQ(client.unauthenticated_packets(), 0);
+    ASSERT_EQ(clientPeer->mtu(), lnl::net_constants::MAX_PACKET_SIZE - lnl::net_constants::ENCRYPTION_TRAILER_SIZE);
+
+    //the handshake works with any key, everything after it doesn't
+    intruder.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !intruderPeer; ++_) {
+        intruder.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(intruderPeer);
+
+    auto data = message(received);
+    writer.reset();
+    writer.write(data.data(), 0, data.size());
+    intruderPeer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+
+    //requests without encryption are not even shown to the listener
+    plain.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < 20; ++_) {
+        intruder.poll_events();
+        plain.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_GT(server.unauthenticated_packets(), 0);
+    ASSERT_EQ(requests, 2);
+}
+
+TEST(net_manager, should_open_sealed_data_in_the_batch_of_the_accept) {
+    static constexpr auto MAX_RETRIES = 200;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    //sealed data right behind the accept, before the client has its keys
+    serverListener.connection_request().subscribe([](auto& request) {
+        auto peer = request->accept();
+        writer.reset();
+        writer.write((uint32_t) 1);
+        peer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+    });
+
+    clientListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        received++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->encryption_enabled = true;
+    }
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    //a plain relay holds back the first two datagrams of the server and hands them over in one call,
+    //so the client reads them in one batch
+    lnl::net_address relayAddress(serverAddress);
+    relayAddress.raw.sin_port = 0;
+
+    auto front = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    auto back = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    socklen_t relayAddressSize = sizeof(relayAddress.raw);
+    ASSERT_EQ(bind(front, (sockaddr*) &relayAddress.raw, sizeof(relayAddress.raw)), 0);
+    ASSERT_EQ(getsockname(front, (sockaddr*) &relayAddress.raw, &relayAddressSize), 0);
+
+    std::atomic<bool> relaying = true;
+    std::thread relay([&] {
+        sockaddr_in clientAddress{};
+        std::vector<std::vector<uint8_t>> held;
+        uint8_t buffer[lnl::net_constants::MAX_PACKET_SIZE];
+
+        while (relaying) {
+            pollfd fds[2] = {{front, POLLIN, 0},
+                             {back,  POLLIN, 0}};
+
+            if (poll(fds, 2, 10) <= 0) {
+                continue;
+            }
+
+            if (fds[0].revents & POLLIN) {
+                socklen_t clientAddressSize = sizeof(clientAddress);
+                auto size = recvfrom(front, buffer, sizeof(buffer), 0, (sockaddr*) &clientAddress, &clientAddressSize);
+
+                if (size > 0) {
+                    sendto(back, buffer, size, 0, (sockaddr*) &serverAddress.raw, sizeof(serverAddress.raw));
+                }
+            }
+
+            if (fds[1].revents & POLLIN) {
+                auto size = recv(back, buffer, sizeof(buffer), 0);
+
+                if (size <= 0) {
+                    continue;
+                }
+
+                if (held.size() >= 2) {
+                    sendto(front, buffer, size, 0, (sockaddr*) &clientAddress, sizeof(clientAddress));
+                    continue;
+                }
+
+                held.emplace_back(buffer, buffer + size);
+
+                if (held.size() < 2) {
+                    continue;
+                }
+
+                std::array<iovec, 2> buffers{};
+                std::array<mmsghdr, 2> messages{};
+
+                for (size_t i = 0; i < held.size(); ++i) {
+                    buffers[i] = {held[i].data(), held[i].size()};
+                    messages[i].msg_hdr.msg_name = &clientAddress;
+                    messages[i].msg_hdr.msg_namelen = sizeof(clientAddress);
+                    messages[i].msg_hdr.msg_iov = &buffers[i];
+                    messages[i].msg_hdr.msg_iovlen = 1;
+                }
+
+                sendmmsg(front, messages.data(), messages.size(), 0);
+            }
+        }
+    });
+
+    client.connect(relayAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && received == 0; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    relaying = false;
+    relay.join();
+    close(front);
+    close(back);
+
+    ASSERT_EQ(received, 1);
+    ASSERT_EQ(client.unauthenticated_packets(), 0);
+}
+
+TEST(net_manager, should_connect_through_cookie_challenge) {
+    static constexpr auto MAX_RETRIES = 100;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t requests = 0;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([&](auto& request) {
+        requests++;
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    server.connect_cookies_enabled = true;
+    client.encryption_enabled = true;
+    server.encryption_enabled = true;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    //the encryption extensions of the request survive the cookie being added to them
+    writer.reset();
+    auto start = std::chrono::steady_clock::now();
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(clientPeer);
+    ASSERT_EQ(requests, 1);
+    ASSERT_EQ(server.connect_challenges(), 1);
+    ASSERT_TRUE(clientPeer->has_feature(lnl::PROTOCOL_FEATURE::ENCRYPTION));
+
+    //the challenge is answered right away, not with the next reconnect attempt
+    ASSERT_LT(elapsed, std::chrono::milliseconds(client.reconnect_delay));
+}
+
+TEST(net_manager, should_rate_limit_unconnected_traffic) {
+    static constexpr auto MAX_RETRIES = 100;
+    static constexpr int DATAGRAMS = 50;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t requests = 0;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([&](auto& request) {
+        requests++;
+        request->accept();
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //next to nothing refills within the test
+    server.unconnected_reply_rate = 0.01;
+    server.unconnected_reply_burst = 5.;
+    server.connect_request_rate = 0.01;
+    server.connect_request_burst = 3.;
+    //the requests of the client are dropped without encryption, so it keeps sending them
+    server.encryption_enabled = true;
+    client.reconnect_delay = 10;
+    client.max_connect_attempts = 30;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    //a plain socket stands in for a scanner, each of its datagrams is worth a PEER_NOT_FOUND
+    auto scanner = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    ASSERT_NE(scanner, -1);
+
+    uint8_t datagram = (uint8_t) lnl::PACKET_PROPERTY::UNRELIABLE;
+
+    for (int i = 0; i < DATAGRAMS; ++i) {
+        sendto(scanner, &datagram, sizeof(datagram), 0, (sockaddr*) &serverAddress.raw, sizeof(serverAddress.raw));
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && server.rate_limited_replies() < DATAGRAMS - 5; ++_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int replies = 0;
+    uint8_t reply[16];
+
+    while (recv(scanner, reply, sizeof(reply), MSG_DONTWAIT) > 0) {
+        ASSERT_EQ(reply[0], (uint8_t) lnl::PACKET_PROPERTY::PEER_NOT_FOUND);
+        replies++;
+    }
+
+    close(scanner);
+
+    ASSERT_EQ(replies, 5);
+    ASSERT_EQ(server.rate_limited_replies(), DATAGRAMS - 5);
+
+    //the same prefix has a bucket of its own for connect requests
+    writer.reset();
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && server.rate_limited_connect_requests() < 10; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_GE(server.rate_limited_connect_requests(), 10);
+    ASSERT_EQ(requests, 0);
+}
+
+TEST(net_manager, should_share_egress_rate_by_weight) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr uint32_t BACKLOG = 400;
+    static constexpr uint32_t PAYLOAD_SIZE = 1000;
+    static constexpr double EGRESS_RATE = 100. * 1000.;
+    static thread_local lnl::net_data_writer writer;
+
+    //two backlogged clients with weights 3 and 1, and a light one sending now and then
+    std::vector<uint32_t> received(3, 0);
+    std::vector<std::shared_ptr<lnl::net_peer>> serverPeers;
+
+    lnl::net_event_based_listener serverListener;
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+    serverListener.peer_connected().subscribe([&](auto& peer) {
+        serverPeers.push_back(peer);
+    });
+
+    lnl::net_manager server(&serverListener);
+    server.max_egress_rate = EGRESS_RATE;
+    server.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    std::vector<std::unique_ptr<lnl::net_event_based_listener>> clientListeners;
+    std::vector<std::unique_ptr<lnl::net_manager>> clients;
+
+    for (size_t i = 0; i < received.size(); ++i) {
+        auto& listener = clientListeners.emplace_back(std::make_unique<lnl::net_event_based_listener>());
+        listener->network_receive().subscribe([&received, i](auto& peer,
+                                                             lnl::net_data_reader& reader,
+                                                             auto channel,
+                                                             auto method) {
+            received[i]++;
+        });
+
+        auto& client = clients.emplace_back(std::make_unique<lnl::net_manager>(listener.get()));
+        client->start();
+
+        //one at a time, so the server peers are in the order of the clients
+        writer.reset();
+        client->connect(serverAddress, writer);
+
+        for (int _ = 0; _ < MAX_RETRIES && serverPeers.size() <= i; ++_) {
+            client->poll_events();
+            server.poll_events();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        ASSERT_EQ(serverPeers.size(), i + 1);
+    }
+
+    serverPeers[0]->set_weight(3.);
+
+    writer.reset();
+
+    for (uint32_t i = 0; i < PAYLOAD_SIZE; ++i) {
+        writer.write((uint8_t) i);
+    }
+
+    for (uint32_t i = 0; i < BACKLOG; ++i) {
+        serverPeers[0]->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+        serverPeers[1]->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    }
+
+    uint32_t lightSent = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int tick = 0; tick < 100; ++tick) {
+        if (tick % 5 == 0) {
+            serverPeers[2]->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+            lightSent++;
+        }
+
+        for (auto& client: clients) {
+            client->poll_events();
+        }
+
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& client: clients) {
+        client->poll_events();
+    }
+
+    //a couple of ticks of credit on top of the rate, headers included
+    auto total = (double) (received[0] + received[1] + received[2]) * PAYLOAD_SIZE;
+    ASSERT_LT(total, EGRESS_RATE * (elapsed + 0.1));
+    ASSERT_GT(total, EGRESS_RATE * elapsed / 2);
+
+    //neither backlog finished, and they split what the light peer left over 3 to 1
+    ASSERT_LT(received[0], BACKLOG);
+    ASSERT_GT(received[1], 0);
+    ASSERT_GT(received[0], received[1] * 2);
+    ASSERT_LT(received[0], received[1] * 4);
+
+    //the light peer is not starved, at most the latest message is still on its way
+    ASSERT_GE(received[2] + 1, lightSent);
+}
+
+TEST(net_manager, should_not_starve_unreliable_behind_reliable_backlog) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr uint32_t BACKLOG = 400;
+    static constexpr uint32_t PAYLOAD_SIZE = 1000;
+    static constexpr double EGRESS_RATE = 50. * 1000.;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<uint32_t> received(2, 0);
+    std::shared_ptr<lnl::net_peer> serverPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.peer_connected().subscribe([&](auto& peer) {
+        serverPeer = peer;
+    });
+
+    clientListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        received[method == lnl::DELIVERY_METHOD::UNRELIABLE ? 1 : 0]++;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    server.max_egress_rate = EGRESS_RATE;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !serverPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(serverPeer);
+
+    writer.reset();
+
+    for (uint32_t i = 0; i < PAYLOAD_SIZE; ++i) {
+        writer.write((uint8_t) i);
+    }
+
+    for (uint32_t i = 0; i < BACKLOG; ++i) {
+        serverPeer->send(writer, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    }
+
+    uint32_t unreliableSent = 0;
+
+    for (int tick = 0; tick < 100; ++tick) {
+        if (tick % 5 == 0) {
+            writer.reset();
+            writer.write(unreliableSent++);
+            serverPeer->send(writer, lnl::DELIVERY_METHOD::UNRELIABLE);
+        }
+
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    client.poll_events();
+
+    //the backlog is still draining, the state updates went out next to it
+    ASSERT_LT(received[0], BACKLOG);
+    ASSERT_GE(received[1] + 1, unreliableSent);
+}
+
+TEST(net_manager, should_deliver_paced_backlog_in_order) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr uint32_t MESSAGES = 300;
+    static constexpr uint32_t PAYLOAD_SIZE = 1000;
+    static thread_local lnl::net_data_writer writer;
+
+    uint32_t received = 0;
+    bool isOrdered = true;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        isOrdered &= reader.read<uint32_t>() == received;
+        received++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    //the backlog takes about a second, far longer than the first resend timers
+    client.pacing_enabled = true;
+    client.pacing_rate = 300. * 1000.;
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+
+    for (uint32_t i = 0; i < MESSAGES; ++i) {
+        writer.reset();
+        writer.write(i);
+
+        for (uint32_t j = sizeof(i); j < PAYLOAD_SIZE; ++j) {
+            writer.write((uint8_t) j);
+        }
+
+        clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    }
+
+    for (int _ = 0; _ < MAX_RETRIES && received < MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received, MESSAGES);
+    ASSERT_TRUE(isOrdered);
+}
+
+namespace {
+    //records what the reliable channels hand to the congestion controller, never limits them
+    class recording_congestion_controller final : public lnl::net_congestion_controller {
+    public:
+        std::mutex mutex;
+        std::vector<std::pair<size_t, int64_t>> sent;
+        std::vector<size_t> acked;
+
+        [[nodiscard]] size_t congestion_window() const override {
+            return SIZE_MAX / 2;
+        }
+
+    protected:
+        void on_sent(size_t bytes, int64_t currentTime) override {
+            std::lock_guard<std::mutex> guard(mutex);
+            sent.emplace_back(bytes, currentTime);
+        }
+
+        void on_acked(size_t bytes, int64_t rtt, int64_t currentTime) override {
+            std::lock_guard<std::mutex> guard(mutex);
+            acked.push_back(bytes);
+        }
+
+        void on_lost(size_t bytes, int64_t sentTime, int64_t currentTime) override {}
+    };
+}
+
+TEST(net_manager, should_resend_by_deadline_with_backoff) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr size_t FIRST_SIZE = 100;
+    static constexpr size_t SECOND_SIZE = 200;
+    static thread_local lnl::net_data_writer writer;
+
+    std::shared_ptr<lnl::net_peer> clientPeer;
+    recording_congestion_controller* recorder = nullptr;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    client.congestion_controller_factory = [&recorder]() {
+        auto controller = std::make_unique<recording_congestion_controller>();
+        recorder = controller.get();
+        return controller;
+    };
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+    ASSERT_TRUE(recorder);
+
+    //nothing gets through, so neither is acked and the resend delay stays the same
+    server.simulation_packet_loss_chance = 100;
+    server.simulate_packet_loss = true;
+
+    auto sendSized = [&](size_t size) {
+        writer.reset();
+
+        for (size_t i = 0; i < size; ++i) {
+            writer.write((uint8_t) i);
+        }
+
+        clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+    };
+
+    sendSized(FIRST_SIZE);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sendSized(SECOND_SIZE);
+
+    //the packets carry a channeled header on top of the message
+    auto firstPacket = FIRST_SIZE + lnl::net_constants::CHANNELED_HEADER_SIZE;
+    auto sendsOf = [&](size_t packetSize) {
+        std::lock_guard<std::mutex> guard(recorder->mutex);
+        std::vector<int64_t> times;
+
+        for (auto& [bytes, time]: recorder->sent) {
+            if (bytes == packetSize) {
+                times.push_back(time);
+            }
+        }
+
+        return times;
+    };
+
+    for (int _ = 0; _ < MAX_RETRIES && sendsOf(firstPacket).size() < 6; ++_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto firstSends = sendsOf(firstPacket);
+    ASSERT_GE(firstSends.size(), 6);
+
+    //the delay doubles per resend up to 2^MAX_RESEND_BACKOFF times
+    std::vector<double> intervals;
+
+    for (size_t i = 1; i < 6; ++i) {
+        intervals.push_back((double) (firstSends[i] - firstSends[i - 1]));
+    }
+
+    for (size_t i = 1; i < 4; ++i) {
+        ASSERT_NEAR(intervals[i] / intervals[i - 1], 2., 0.5);
+    }
+
+    ASSERT_NEAR(intervals[4] / intervals[3], 1., 0.25);
+
+    //the earlier deadline goes first every time
+    {
+        std::lock_guard<std::mutex> guard(recorder->mutex);
+        size_t expected = firstPacket;
+
+        for (auto& [bytes, time]: recorder->sent) {
+            ASSERT_EQ(bytes, expected);
+            expected = expected == firstPacket ? SECOND_SIZE + lnl::net_constants::CHANNELED_HEADER_SIZE
+                                               : firstPacket;
+        }
+    }
+
+    server.simulate_packet_loss = false;
+
+    for (int _ = 0; _ < MAX_RETRIES; ++_) {
+        {
+            std::lock_guard<std::mutex> guard(recorder->mutex);
+
+            if (recorder->acked.size() == 2) {
+                break;
+            }
+        }
+
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    size_t sentCount;
+
+    {
+        std::lock_guard<std::mutex> guard(recorder->mutex);
+        ASSERT_EQ(recorder->acked.size(), 2);
+        sentCount = recorder->sent.size();
+    }
+
+    //acked entries leave the resend queue without being sent again
+    std::this_thread::sleep_for(std::chrono::milliseconds((int64_t) (intervals[4] / lnl::TICKS_PER_MILLISECOND * 2)));
+
+    std::lock_guard<std::mutex> guard(recorder->mutex);
+    ASSERT_EQ(recorder->sent.size(), sentCount);
+}
+
+TEST(net_manager, should_send_immediately_and_on_flush_on_calling_thread) {
+    static constexpr auto MAX_RETRIES = 300;
+    static constexpr uint32_t IMMEDIATE_MESSAGES = 50;
+    static constexpr uint32_t QUEUED_MESSAGES = 2000;
+    //tells the sends of channel 0 apart from the small ones of channel 1
+    static constexpr size_t IMMEDIATE_SIZE = 600;
+    static thread_local lnl::net_data_writer writer;
+
+    std::vector<uint32_t> received(2, 0);
+    bool inOrder = true;
+    std::shared_ptr<lnl::net_peer> clientPeer;
+    recording_congestion_controller* recorder = nullptr;
+
+    lnl::net_event_based_listener serverListener;
+    lnl::net_event_based_listener clientListener;
+
+    serverListener.connection_request().subscribe([](auto& request) {
+        request->accept();
+    });
+
+    serverListener.network_receive().subscribe([&](auto& peer,
+                                                   lnl::net_data_reader& reader,
+                                                   auto channel,
+                                                   auto method) {
+        inOrder = inOrder && reader.read<uint32_t>() == received[channel];
+        received[channel]++;
+    });
+
+    clientListener.peer_connected().subscribe([&](auto& peer) {
+        clientPeer = peer;
+    });
+
+    lnl::net_manager server(&serverListener);
+    lnl::net_manager client(&clientListener);
+
+    for (auto manager: {&server, &client}) {
+        manager->channels_count = 2;
+    }
+
+    client.congestion_controller_factory = [&recorder]() {
+        auto controller = std::make_unique<recording_congestion_controller>();
+        recorder = controller.get();
+        return controller;
+    };
+
+    server.start();
+    client.start();
+
+    lnl::net_address serverAddress(server.address());
+    serverAddress.set_address("localhost");
+
+    client.connect(serverAddress, writer);
+
+    for (int _ = 0; _ < MAX_RETRIES && !clientPeer; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(clientPeer);
+    ASSERT_NE(recorder, nullptr);
+
+    auto immediateSends = [recorder] {
+        std::lock_guard<std::mutex> guard(recorder->mutex);
+        return std::count_if(recorder->sent.begin(), recorder->sent.end(), [](auto& sent) {
+            return sent.first >= IMMEDIATE_SIZE;
+        });
+    };
+
+    //a user thread keeps channel 1 busy with queued sends and flushes while the logic thread runs its passes
+    std::thread sender([&] {
+        lnl::net_data_writer queuedWriter;
+
+        for (uint32_t i = 0; i < QUEUED_MESSAGES; ++i) {
+            queuedWriter.reset();
+            queuedWriter.write(i);
+            clientPeer->send(queuedWriter, 1, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+
+            if (i % 10 == 0) {
+                clientPeer->flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    });
+
+    for (uint32_t i = 0; i < IMMEDIATE_MESSAGES; ++i) {
+        writer.reset();
+        writer.write(i);
+
+        for (size_t j = sizeof(i); j < IMMEDIATE_SIZE; ++j) {
+            writer.write((uint8_t) j);
+        }
+
+        //the logic thread would only get to a queued packet after its wakeup, so it has to be gone on return
+        if (i % 2 == 0) {
+            clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED, true);
+        } else {
+            clientPeer->send(writer, 0, lnl::DELIVERY_METHOD::RELIABLE_ORDERED);
+            clientPeer->flush();
+        }
+
+        ASSERT_EQ(immediateSends(), i + 1);
+
+        for (int _ = 0; _ < MAX_RETRIES && received[0] <= i; ++_) {
+            server.poll_events();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ASSERT_EQ(received[0], i + 1);
+    }
+
+    sender.join();
+
+    for (int _ = 0; _ < MAX_RETRIES && received[1] < QUEUED_MESSAGES; ++_) {
+        client.poll_events();
+        server.poll_events();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_EQ(received[1], QUEUED_MESSAGES);
+    ASSERT_TRUE(inOrder);
+}
@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_pacer.h>
+
+TEST(net_pacer, should_limit_rate_after_burst) {
+    static constexpr size_t DATAGRAM = 1000;
+
+    lnl::net_pacer pacer;
+    //1000 bytes per millisecond, burst of two datagrams
+    pacer.set_rate(1000. * 1000., 2 * DATAGRAM);
+
+    int64_t time = lnl::TICKS_PER_SECOND;
+
+    ASSERT_TRUE(pacer.try_consume(DATAGRAM, time));
+    ASSERT_TRUE(pacer.try_consume(DATAGRAM, time));
+    ASSERT_FALSE(pacer.try_consume(DATAGRAM, time));
+
+    auto delay = pacer.delay_for(DATAGRAM);
+    ASSERT_NEAR((double) delay, (double) lnl::TICKS_PER_MILLISECOND, 2.);
+
+    ASSERT_FALSE(pacer.try_consume(DATAGRAM, time + delay / 2));
+    ASSERT_TRUE(pacer.try_consume(DATAGRAM, time + delay));
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_rate_limiter.h>
+
+TEST(net_rate_limiter, should_limit_each_source_after_burst) {
+    lnl::net_rate_limiter limiter;
+    //ten per second, three at once
+    limiter.set_rate(10., 3.);
+
+    int64_t time = lnl::TICKS_PER_SECOND;
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(limiter.try_acquire(1, time));
+    }
+
+    ASSERT_FALSE(limiter.try_acquire(1, time));
+
+    //other sources keep their buckets
+    for (uint64_t key = 2; key < 100; ++key) {
+        ASSERT_TRUE(limiter.try_acquire(key, time));
+    }
+
+    ASSERT_FALSE(limiter.try_acquire(1, time + lnl::TICKS_PER_SECOND / 20));
+    ASSERT_TRUE(limiter.try_acquire(1, time + lnl::TICKS_PER_SECOND / 10));
+    ASSERT_FALSE(limiter.try_acquire(1, time + lnl::TICKS_PER_SECOND / 10));
+
+    //a long pause refills the whole burst and no more
+    time += 2 * lnl::TICKS_PER_SECOND;
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(limiter.try_acquire(1, time));
+    }
+
+    ASSERT_FALSE(limiter.try_acquire(1, time));
+}
+
+TEST(net_rate_limiter, should_stay_bounded_with_many_sources) {
+    lnl::net_rate_limiter limiter(256);
+    limiter.set_rate(1., 2.);
+
+    int64_t time = lnl::TICKS_PER_SECOND;
+    uint32_t allowed = 0;
+
+    //far more sources than cells, each one trying ten times
+    for (uint64_t key = 0; key < 2000; ++key) {
+        for (int i = 0; i < 10; ++i) {
+            allowed += limiter.try_acquire(key, time);
+        }
+    }
+
+    //collisions only ever take tokens away
+    ASSERT_LE(allowed, 2000 * 2);
+    ASSERT_GT(allowed, 0);
+
+    limiter.set_rate(0., 0.);
+    ASSERT_FALSE(limiter.enabled());
+}
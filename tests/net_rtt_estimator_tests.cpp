@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_rtt_estimator.h>
+
+TEST(net_rtt_estimator, should_follow_jitter) {
+    lnl::net_rtt_estimator estimator;
+    estimator.add_sample(100.);
+
+    ASSERT_DOUBLE_EQ(estimator.srtt(), 100.);
+    ASSERT_DOUBLE_EQ(estimator.rttvar(), 50.);
+
+    //a stable link converges close to its rtt
+    for (int i = 0; i < 100; ++i) {
+        estimator.add_sample(100.);
+    }
+
+    auto stableRto = estimator.rto(15., 25., 2000.);
+    ASSERT_NEAR(stableRto, 115., 1.);
+
+    //a jittery link with the same average waits longer
+    for (int i = 0; i < 100; ++i) {
+        estimator.add_sample(i % 2 == 0 ? 50. : 150.);
+    }
+
+    ASSERT_NEAR(estimator.srtt(), 100., 10.);
+    ASSERT_GT(estimator.rto(15., 25., 2000.), stableRto + 100.);
+    ASSERT_DOUBLE_EQ(estimator.rto(15., 25., 200.), 200.);
+}
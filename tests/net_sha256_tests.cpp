@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <lnl/net_sha256.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+    std::string to_hex(const uint8_t* data, size_t size) {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string result;
+
+        for (size_t i = 0; i < size; ++i) {
+            result += DIGITS[data[i] >> 4];
+            result += DIGITS[data[i] & 0x0F];
+        }
+
+        return result;
+    }
+
+    std::string sha256(const std::string& text, size_t chunkSize) {
+        lnl::net_sha256 hash;
+        uint8_t digest[lnl::net_sha256::DIGEST_SIZE];
+
+        for (size_t pos = 0; pos < text.size(); pos += chunkSize) {
+            hash.update((const uint8_t*) &text[pos], std::min(chunkSize, text.size() - pos));
+        }
+
+        hash.finish(digest);
+        return to_hex(digest, sizeof(digest));
+    }
+}
+
+TEST(net_sha256, should_match_fips_180_vectors) {
+    //split updates have to give the same digest
+    for (size_t chunkSize: {1, 7, 64, 1000}) {
+        ASSERT_EQ(sha256("", chunkSize), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        ASSERT_EQ(sha256("abc", chunkSize), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        ASSERT_EQ(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", chunkSize),
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    }
+}
+
+TEST(net_sha256, should_match_rfc_4231_hmac_vectors) {
+    uint8_t mac[lnl::net_sha256::DIGEST_SIZE];
+
+    std::string key = "Jefe";
+    std::string data = "what do ya want for nothing?";
+    lnl::hmac_sha256((const uint8_t*) key.data(), key.size(), (const uint8_t*) data.data(), data.size(), mac);
+    ASSERT_EQ(to_hex(mac, sizeof(mac)), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    std::vector<uint8_t> longKey(131, 0xAA);
+    data = "Test Using Larger Than Block-Size Key - Hash Key First";
+    lnl::hmac_sha256(longKey.data(), longKey.size(), (const uint8_t*) data.data(), data.size(), mac);
+    ASSERT_EQ(to_hex(mac, sizeof(mac)), "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}